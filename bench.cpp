@@ -0,0 +1,362 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "minijson.hpp"
+#include "minijson_arena.hpp"
+#include "minijson_file.hpp"
+#include "minijson_stats.hpp"
+#include "minijson_writer.hpp"
+
+// Usage: bench [--min-time <seconds>] [--save <baseline>] [--compare <baseline>]
+//              [--threshold <percent>] [<file>...]
+// Runs on every file passed (e.g. twitter.json, canada.json, citm_catalog.json) and on a couple
+// of generated inputs. Parse, lookup and dump are measured separately for each memory resource.
+// Peak RSS is that of the whole process so far, so it only ever grows from row to row.
+// --save writes the throughput of every row to a JSON file. --compare fails (exit code 2) if any
+// row is more than --threshold percent (default 10) slower than in such a file, so it has to be
+// run on the same files and on the same machine.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct Corpus {
+    std::string name;
+    std::string data;
+    // NDJSON corpora have one document per line
+    bool ndjson;
+};
+
+struct ResourceFactory {
+    std::string name;
+    std::function<std::unique_ptr<std::pmr::memory_resource>()> create;
+};
+
+// nullptr means the default resource
+const std::vector<ResourceFactory> resourceFactories = {
+    { "default", [] { return nullptr; } },
+    { "monotonic", [] { return std::make_unique<std::pmr::monotonic_buffer_resource>(); } },
+    { "pool", [] { return std::make_unique<std::pmr::unsynchronized_pool_resource>(); } },
+    { "arena", [] { return std::make_unique<minijson::Arena>(); } },
+};
+
+bool readFile(const std::string& path, std::string& data)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    std::fseek(f, 0, SEEK_END);
+    const auto size = std::ftell(f);
+    std::fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        std::fclose(f);
+        return false;
+    }
+    data.resize(static_cast<size_t>(size));
+    const auto readRes = std::fread(data.data(), 1, data.size(), f);
+    std::fclose(f);
+    return readRes == data.size();
+}
+
+bool endsWith(std::string_view str, std::string_view suffix)
+{
+    return str.size() >= suffix.size() && str.substr(str.size() - suffix.size()) == suffix;
+}
+
+std::vector<std::string_view> splitLines(std::string_view data)
+{
+    std::vector<std::string_view> lines;
+    size_t start = 0;
+    while (start < data.size()) {
+        auto end = data.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = data.size();
+        }
+        if (end > start) {
+            lines.push_back(data.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return lines;
+}
+
+Corpus makeNdjson(size_t numLines)
+{
+    Corpus corpus { "synthetic.ndjson", {}, true };
+    for (size_t i = 0; i < numLines; ++i) {
+        corpus.data += "{\"id\": " + std::to_string(i) + ", \"name\": \"user" + std::to_string(i)
+            + "\", \"score\": " + std::to_string(static_cast<double>(i) * 0.37)
+            + ", \"active\": " + (i % 3 ? "true" : "false")
+            + ", \"tags\": [\"a\", \"bb\", \"ccc\"], \"parent\": null}\n";
+    }
+    return corpus;
+}
+
+// Must stay within the default ParseOptions::maxDepth (1024)
+Corpus makeDeepNesting(size_t depth)
+{
+    Corpus corpus { "synthetic-deep.json", {}, false };
+    for (size_t i = 0; i < depth; ++i) {
+        corpus.data += i % 2 ? "[" : "{\"k\": ";
+    }
+    corpus.data += "1";
+    for (size_t i = depth; i-- > 0;) {
+        corpus.data += i % 2 ? "]" : "}";
+    }
+    return corpus;
+}
+
+// Looks up every key of every object through operator[]
+size_t lookupAll(const minijson::JsonValue& value)
+{
+    size_t lookups = 0;
+    if (value.isArray()) {
+        for (const auto& elem : value.asArray()) {
+            lookups += lookupAll(elem);
+        }
+    } else if (value.isObject()) {
+        for (const auto& [key, member] : value.asObject()) {
+            lookups += value[key.view()].isValid();
+            lookups += lookupAll(member);
+        }
+    }
+    return lookups;
+}
+
+size_t getPeakRssKb()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_maxrss); // KiB on Linux
+}
+
+// Repeats func until minTime has passed (at least 3 times) and returns seconds per run
+template <typename Func>
+double measure(double minTime, Func&& func)
+{
+    size_t runs = 0;
+    const auto start = Clock::now();
+    double elapsed = 0.0;
+    while (runs < 3 || elapsed < minTime) {
+        func();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return elapsed / static_cast<double>(runs);
+}
+
+struct Row {
+    std::string name; // corpus/resource/phase
+    double gbPerSecond;
+};
+
+std::vector<Row> rows;
+
+void printRow(const std::string& corpus, const std::string& resource, const char* phase,
+    size_t bytes, size_t docs, double seconds, double allocsPerDoc)
+{
+    rows.push_back(
+        Row { corpus + "/" + resource + "/" + phase, static_cast<double>(bytes) / seconds / 1e9 });
+    std::printf("%-22s %-10s %-7s %8.3f GB/s %12.0f docs/s %10.1f allocs/doc %8zu KiB peak RSS\n",
+        corpus.c_str(), resource.c_str(), phase, static_cast<double>(bytes) / seconds / 1e9,
+        static_cast<double>(docs) / seconds, allocsPerDoc, getPeakRssKb());
+}
+
+bool run(const Corpus& corpus, const ResourceFactory& factory, double minTime)
+{
+    const auto documents = corpus.ndjson ? splitLines(corpus.data)
+                                         : std::vector<std::string_view> { corpus.data };
+    size_t inputBytes = 0;
+    for (const auto doc : documents) {
+        inputBytes += doc.size();
+    }
+    const auto numDocs = documents.size();
+
+    // Every run gets a fresh resource, so monotonic doesn't grow without bound
+    std::unique_ptr<std::pmr::memory_resource> resource;
+    // The values keep a pointer to this, so it has to live as long as they do
+    std::unique_ptr<minijson::CountingResource> counting;
+    std::vector<minijson::JsonValue> values;
+    size_t allocations = 0;
+    bool ok = true;
+    const auto parseAll = [&] {
+        values.clear();
+        resource = factory.create();
+        counting = std::make_unique<minijson::CountingResource>(
+            resource ? resource.get() : std::pmr::get_default_resource());
+        for (const auto doc : documents) {
+            auto res = minijson::parse(doc, counting.get());
+            if (!res) {
+                ok = false;
+                return;
+            }
+            values.push_back(std::move(*res));
+        }
+        allocations = counting->allocations();
+    };
+
+    const auto parseTime = measure(minTime, parseAll);
+    if (!ok) {
+        std::cerr << corpus.name << ": parse error" << std::endl;
+        return false;
+    }
+    printRow(corpus.name, factory.name, "parse", inputBytes, numDocs, parseTime,
+        static_cast<double>(allocations) / static_cast<double>(numDocs));
+
+    size_t lookups = 0;
+    const auto lookupTime = measure(minTime, [&] {
+        lookups = 0;
+        for (const auto& value : values) {
+            lookups += lookupAll(value);
+        }
+    });
+    printRow(corpus.name, factory.name, "lookup", inputBytes, numDocs, lookupTime, 0.0);
+
+    std::string out;
+    const auto dumpTime = measure(minTime, [&] {
+        out.clear();
+        minijson::StringSink sink(out);
+        for (const auto& value : values) {
+            minijson::write(value, sink);
+        }
+    });
+    // Relative to the size of the input, so the numbers are comparable to parse
+    printRow(corpus.name, factory.name, "dump", inputBytes, numDocs, dumpTime, 0.0);
+
+    // Every document is parsed into the same value, which reuses the capacity of the previous one
+    minijson::JsonValue reused;
+    const auto reparseTime = measure(minTime, [&] {
+        const auto before = counting->allocations();
+        for (const auto doc : documents) {
+            if (minijson::parseInto(reused, doc, counting.get())) {
+                ok = false;
+                return;
+            }
+        }
+        allocations = counting->allocations() - before;
+    });
+    if (!ok) {
+        std::cerr << corpus.name << ": reparse error" << std::endl;
+        return false;
+    }
+    printRow(corpus.name, factory.name, "reparse", inputBytes, numDocs, reparseTime,
+        static_cast<double>(allocations) / static_cast<double>(numDocs));
+
+    // The values refer to the resource, so they have to go first
+    values.clear();
+    return true;
+}
+
+bool saveBaseline(const std::string& path)
+{
+    auto baseline = minijson::JsonValue::makeObject();
+    for (const auto& row : rows) {
+        baseline.set(row.name, minijson::JsonValue(row.gbPerSecond));
+    }
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    const auto json = baseline.dump("  ");
+    const auto written = std::fwrite(json.data(), 1, json.size(), f) == json.size();
+    return std::fclose(f) == 0 && written;
+}
+
+// Returns the number of rows that are slower than the baseline allows or -1 if it can't be read
+int compareBaseline(const std::string& path, double threshold)
+{
+    const auto baseline = minijson::parseFile(path);
+    if (!baseline || !baseline->root().isObject()) {
+        std::cerr << "Could not read baseline " << path;
+        if (!baseline) {
+            std::cerr << ": " << baseline.error().message();
+        }
+        std::cerr << std::endl;
+        return -1;
+    }
+    int regressions = 0;
+    for (const auto& row : rows) {
+        const auto& expected = baseline->root()[row.name];
+        if (!expected.isNumber()) {
+            std::printf("%-50s not in baseline\n", row.name.c_str());
+            continue;
+        }
+        const auto change = (row.gbPerSecond / expected.asNumber() - 1.0) * 100.0;
+        if (change < -threshold) {
+            regressions++;
+            std::printf("%-50s %8.3f GB/s, baseline %8.3f GB/s (%+.1f%%) REGRESSION\n",
+                row.name.c_str(), row.gbPerSecond, expected.asNumber(), change);
+        }
+    }
+    std::printf("%d of %zu rows regressed by more than %.1f%%\n", regressions, rows.size(),
+        threshold);
+    return regressions;
+}
+}
+
+int main(int argc, char** argv)
+{
+    const std::vector<std::string> args(argv + 1, argv + argc);
+    double minTime = 0.5;
+    std::string savePath;
+    std::string comparePath;
+    double threshold = 10.0;
+    std::vector<Corpus> corpora;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--min-time" && i + 1 < args.size()) {
+            minTime = std::stod(args[++i]);
+            continue;
+        }
+        if (args[i] == "--save" && i + 1 < args.size()) {
+            savePath = args[++i];
+            continue;
+        }
+        if (args[i] == "--compare" && i + 1 < args.size()) {
+            comparePath = args[++i];
+            continue;
+        }
+        if (args[i] == "--threshold" && i + 1 < args.size()) {
+            threshold = std::stod(args[++i]);
+            continue;
+        }
+        const auto ndjson = endsWith(args[i], ".ndjson") || endsWith(args[i], ".jsonl");
+        Corpus corpus { args[i], {}, ndjson };
+        if (!readFile(args[i], corpus.data)) {
+            std::cerr << "Could not read " << args[i] << std::endl;
+            return 1;
+        }
+        corpora.push_back(std::move(corpus));
+    }
+    corpora.push_back(makeNdjson(10000));
+    corpora.push_back(makeDeepNesting(1000));
+
+    bool ok = true;
+    for (const auto& corpus : corpora) {
+        for (const auto& factory : resourceFactories) {
+            ok = run(corpus, factory, minTime) && ok;
+        }
+    }
+    if (!ok) {
+        return 1;
+    }
+    if (!savePath.empty() && !saveBaseline(savePath)) {
+        std::cerr << "Could not write " << savePath << std::endl;
+        return 1;
+    }
+    if (!comparePath.empty()) {
+        const auto regressions = compareBaseline(comparePath, threshold);
+        if (regressions != 0) {
+            return regressions < 0 ? 1 : 2;
+        }
+    }
+    return 0;
+}
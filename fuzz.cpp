@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "minijson.hpp"
+#include "minijson_binary.hpp"
+#include "minijson_document.hpp"
+#include "minijson_scan.hpp"
+#include "minijson_stream.hpp"
+#include "minijson_tape.hpp"
+#include "minijson_validate.hpp"
+
+// Differential fuzz target: every fast path has to agree with parse() using the scalar scanners.
+// Built with MINIJSON_LIBFUZZER this is a libFuzzer target. Otherwise it has a main that runs
+// every file that is passed (or stdin), which is what AFL and corpus replays need:
+//   fuzz [<file>...]
+
+namespace {
+using namespace minijson;
+
+void check(bool condition, const char* what, std::string_view input)
+{
+    if (!condition) {
+        std::cerr << "Mismatch (" << what << ") for input of " << input.size() << " bytes"
+                  << std::endl;
+        std::abort();
+    }
+}
+
+bool sameResult(const Result<JsonValue>& a, const Result<JsonValue>& b)
+{
+    if (!a || !b) {
+        return !a && !b && a.error().code == b.error().code
+            && a.error().cursor == b.error().cursor;
+    }
+    return a->dump() == b->dump();
+}
+
+bool equal(ValueRef tape, const JsonValue& value)
+{
+    switch (value.type()) {
+    case JsonValue::Type::Null:
+        return tape.isNull();
+    case JsonValue::Type::Bool:
+        return tape.isBool() && tape.asBool() == value.asBool();
+    case JsonValue::Type::Number:
+        if (value.isInt()) {
+            return tape.isInt() && tape.asInt() == value.asInt();
+        } else if (value.isUInt()) {
+            return tape.isUInt() && tape.asUInt() == value.asUInt();
+        }
+        return tape.isNumber() && !tape.isInt() && !tape.isUInt()
+            && tape.asNumber() == value.asNumber();
+    case JsonValue::Type::String:
+        return tape.isString() && tape.asString() == value.asString().view();
+    case JsonValue::Type::Array: {
+        if (!tape.isArray() || tape.size() != value.size()) {
+            return false;
+        }
+        size_t i = 0;
+        for (const auto element : tape.asArray()) {
+            if (!equal(element, value[i++])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    case JsonValue::Type::Object:
+        // The tape keeps duplicate keys, the DOM only the first one (which is what the tape
+        // finds too)
+        if (!tape.isObject() || tape.size() < value.size()) {
+            return false;
+        }
+        for (const auto [key, member] : tape.asObject()) {
+            if (!value[key].isValid()) {
+                return false;
+            }
+        }
+        for (const auto& [key, member] : value.asObject()) {
+            if (!equal(tape[key.view()], member)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Visits every value and touches every key and string, so sanitizers see reads out of bounds
+size_t countValues(ValueRef value, size_t& bytes)
+{
+    size_t count = 1;
+    if (value.isArray()) {
+        for (const auto element : value.asArray()) {
+            count += countValues(element, bytes);
+        }
+    } else if (value.isObject()) {
+        for (const auto [key, member] : value.asObject()) {
+            bytes += std::count(key.begin(), key.end(), '"');
+            count += countValues(member, bytes);
+        }
+    } else if (value.isString()) {
+        const auto str = value.asString();
+        bytes += std::count(str.begin(), str.end(), '"');
+    }
+    return count;
+}
+
+bool hasControlCharacters(std::string_view input)
+{
+    for (const auto ch : input) {
+        if (static_cast<unsigned char>(ch) < 0x20) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void checkInput(std::string_view input)
+{
+    const auto best = detail::getSupportedSimdLevel();
+    detail::setSimdLevel(detail::SimdLevel::Scalar);
+    const auto reference = parse(input);
+
+    for (const auto level :
+        { detail::SimdLevel::Sse2, detail::SimdLevel::Avx2, detail::SimdLevel::Neon }) {
+        if (detail::setSimdLevel(level)) {
+            check(sameResult(parse(input), reference), "SIMD scanners", input);
+        }
+    }
+    detail::setSimdLevel(best);
+
+    static JsonValue reused;
+    const auto reuseError = parseInto(reused, input);
+    check(!reuseError == bool(reference), "parseInto", input);
+    check(!reference || reused.dump() == reference->dump(), "parseInto", input);
+
+    Document document;
+    const auto documentOk = document.parse(input);
+    check(documentOk == bool(reference), "Document", input);
+    ParallelOptions parallelOptions;
+    parallelOptions.numThreads = 2;
+    parallelOptions.batchSize = 1;
+    ParallelDocument parallel(parallelOptions);
+    const auto parallelOk = parallel.parse(input);
+    check(parallelOk == documentOk, "ParallelDocument", input);
+    check(parallelOk ? parallel.root().dump() == document.root().dump()
+                     : parallel.error().cursor == document.error().cursor,
+        "ParallelDocument", input);
+
+    const auto tape = parseTape(input);
+    check(bool(tape) == bool(reference), "parseTape", input);
+    if (tape) {
+        check(equal(tape->root(), *reference), "parseTape", input);
+        const auto blob = encodeTape(*tape);
+        const auto decoded = decodeTape(blob);
+        check(decoded && equal(decoded->root(), *reference), "binary tape", input);
+    }
+    // Anything (including garbage) must either be rejected or be safe to navigate
+    const std::string copy(input);
+    if (const auto decoded = decodeTape(copy)) {
+        size_t bytes = 0;
+        check(countValues(decoded->root(), bytes) <= decoded->numEntries(), "decodeTape", input);
+    }
+
+    StreamParser stream;
+    const auto chunkSize = 1 + input.size() % 7;
+    for (size_t i = 0; i < input.size(); i += chunkSize) {
+        if (!stream.feed(input.substr(i, chunkSize))) {
+            break;
+        }
+    }
+    const auto streamed = stream.finish();
+    check(bool(streamed) == bool(reference), "StreamParser", input);
+    check(reference ? streamed->dump() == reference->dump()
+                    : streamed.error().code == reference.error().code
+                && streamed.error().cursor == reference.error().cursor,
+        "StreamParser", input);
+
+    // Everything after the first value is the next document of the sequence
+    DocumentSequence sequence(input);
+    if (reference) {
+        check(sequence.next() && sequence.root().dump() == reference->dump(), "sequence", input);
+        check(!sequence.next() && sequence.error().code == ErrorCode::None, "sequence", input);
+    }
+
+    // validate also checks UTF-8 and control characters, which parse doesn't by default, but not
+    // the range of numbers
+    ParseOptions utf8;
+    utf8.validateUtf8 = true;
+    const auto strict = parse(input, utf8);
+    const auto valid = validate(input);
+    check(!valid || strict || strict.error().code == ErrorCode::InvalidNumber, "validate", input);
+    check(!strict || bool(valid) || hasControlCharacters(input), "validate", input);
+}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    checkInput(std::string_view(reinterpret_cast<const char*>(data), size));
+    return 0;
+}
+
+#ifndef MINIJSON_LIBFUZZER
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        const std::string input(std::istreambuf_iterator<char>(std::cin), {});
+        const auto data = reinterpret_cast<const uint8_t*>(input.data());
+        return LLVMFuzzerTestOneInput(data, input.size());
+    }
+    for (int i = 1; i < argc; ++i) {
+        std::FILE* f = std::fopen(argv[i], "rb");
+        if (!f) {
+            std::cerr << "Could not open " << argv[i] << std::endl;
+            return 1;
+        }
+        std::string input;
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+            input.append(buffer, n);
+        }
+        std::fclose(f);
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+    }
+    std::cout << "Checked " << argc - 1 << " inputs" << std::endl;
+    return 0;
+}
+#endif
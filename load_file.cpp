@@ -1,11 +1,11 @@
 #include <cassert>
 #include <chrono>
-#include <cstdio>
 #include <iostream>
 #include <string_view>
 #include <vector>
 
 #include "minijson.hpp"
+#include "minijson_file.hpp"
 
 void printValue(const minijson::JsonValue& value, size_t indent = 0)
 {
@@ -51,25 +51,12 @@ int main(int argc, char** argv)
 
     const auto readStart = std::chrono::high_resolution_clock::now();
 
-    FILE* f = std::fopen(args[0].c_str(), "rb");
-    if (!f) {
-        std::cerr << "Could not open file" << std::endl;
-        return 1;
-    }
-    std::fseek(f, 0, SEEK_END);
-    const auto size = std::ftell(f);
-    if (size < 0) {
-        std::cerr << "Error getting file size" << std::endl;
-        return 1;
-    }
-    std::fseek(f, 0, SEEK_SET);
-    std::string json;
-    json.resize(size);
-    const auto readRes = std::fread(json.data(), 1, size, f);
-    if (readRes != static_cast<size_t>(size)) {
-        std::cerr << "Error reading file: " << readRes << std::endl;
+    auto file = minijson::MappedFile::open(args[0]);
+    if (!file) {
+        std::cerr << file.error().message() << std::endl;
         return 1;
     }
+    const auto json = file->view();
 
     std::cerr << "Read file: "
               << std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -81,18 +68,18 @@ int main(int argc, char** argv)
 
     std::pmr::monotonic_buffer_resource pool(2048);
 
-    const auto num_it = argc > 1 ? std::stoi(args[1]) : 1;
+    const auto num_it = args.size() > 1 ? std::stoi(args[1]) : 1;
     minijson::Result<minijson::JsonValue> res(minijson::Error {});
     for (int i = 0; i < num_it; ++i) {
+        // The previous result is still alive until it is overwritten
+        res = minijson::Error {};
+        pool.release();
         res = minijson::parse(json, &pool);
         if (!res) {
             const auto& err = res.error();
-            std::cerr << "Could not parse json: " << err.message << " at " << err.cursor
-                      << std::endl;
-            std::cout << minijson::getContext(json, err.cursor) << std::endl;
+            std::cerr << "Could not parse json: " << err.describe(json) << std::endl;
             return 1;
         }
-        pool.release();
     }
 
     std::cerr << "Parse: "
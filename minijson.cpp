@@ -1,253 +1,11 @@
 #include "minijson.hpp"
 
-#include <cassert>
-#include <charconv>
-#include <optional>
-#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <ostream>
 
-using namespace minijson;
-
-namespace {
-Result<JsonValue::String> parseString(
-    std::string_view source, size_t& cursor, std::pmr::memory_resource* memRes)
-{
-    assert(cursor < source.size());
-    assert(source[cursor] == '"');
-    cursor++;
-    JsonValue::String str(memRes);
-    str.reserve(32);
-    while (cursor < source.size()) {
-        if (source[cursor] == '\\') {
-            cursor++;
-            if (cursor >= source.size()) {
-                return Error { cursor, "Incomplete character escape" };
-            }
-            const auto c = source[cursor];
-
-            if (c == 'u') {
-                return Error { cursor, "Unicode escapes are not implemented yet" };
-            }
-
-            static const std::unordered_map<char, std::string_view> escapes {
-                { '"', "\"" },
-                { '\\', "\\" },
-                { '/', "/" },
-                { 'b', "\b" },
-                { 'f', "\f" },
-                { 'n', "\n" },
-                { 'r', "\r" },
-                { 't', "\t" },
-            };
-            const auto it = escapes.find(c);
-            if (it == escapes.end()) {
-                return Error { cursor,
-                    std::string("Invalid character escape '") + c + "' (" + std::to_string(c)
-                        + ")" };
-            }
-
-            str.append(it->second);
-            cursor++;
-        } else if (source[cursor] == '"') {
-            cursor++;
-            return str;
-        } else {
-            str.push_back(source[cursor]);
-            cursor++;
-        }
-    }
-    return Error { cursor, "Unterminated string" };
-}
-
-bool isWhitespace(char ch)
-{
-    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\t';
-}
-
-void skipWhitespace(std::string_view source, size_t& cursor)
-{
-    while (cursor < source.size() && isWhitespace(source[cursor])) {
-        cursor++;
-    }
-}
-
-std::optional<double> parseNumber(std::string_view str)
-{
-    double value = 0.0;
-    const auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
-    if (ec != std::errc() || ptr != str.data() + str.size()) {
-        return std::nullopt;
-    }
-    return value;
-}
-
-bool skipSeparator(std::string_view source, size_t& cursor)
-{
-    skipWhitespace(source, cursor);
-    if (cursor < source.size() && source[cursor] == ',') {
-        cursor++;
-        skipWhitespace(source, cursor);
-        return true;
-    }
-    return false;
-}
-
-Result<JsonValue> parseValue(
-    std::string_view source, size_t& cursor, std::pmr::memory_resource* memRes);
-
-Result<JsonValue> parseArray(
-    std::string_view source, size_t& cursor, std::pmr::memory_resource* memRes)
-{
-    JsonValue::Array values(memRes);
-    while (cursor < source.size()) {
-        skipWhitespace(source, cursor);
-
-        if (cursor >= source.size()) {
-            return Error { cursor, "Unterminated array" };
-        }
-
-        if (source[cursor] == ']') {
-            cursor++;
-            break;
-        }
-
-        auto value = parseValue(source, cursor, memRes);
-        if (!value) {
-            return value.error();
-        }
-        values.push_back(std::move(*value));
-
-        const auto separatorFound = skipSeparator(source, cursor);
-        if (cursor < source.size() && source[cursor] == ']') {
-            cursor++;
-            break;
-        }
-
-        if (!separatorFound) {
-            return Error { cursor, "Expected separator" };
-        }
-    }
-    return JsonValue(values);
-}
-
-Result<JsonValue> parseObject(
-    std::string_view source, size_t& cursor, std::pmr::memory_resource* memRes)
-{
-    JsonValue::Object obj(memRes);
-    while (cursor < source.size()) {
-        skipWhitespace(source, cursor);
-
-        if (cursor >= source.size()) {
-            return Error { cursor, "Unterminated object" };
-        }
-
-        if (source[cursor] == '}') {
-            cursor++;
-            break;
-        }
-
-        if (source[cursor] != '"') {
-            return Error { cursor, "Expected key" };
-        }
-
-        const auto key = parseString(source, cursor, memRes);
-        if (!key) {
-            return key.error();
-        }
-
-        skipWhitespace(source, cursor);
-
-        if (cursor >= source.size() || source[cursor] != ':') {
-            return Error { cursor, "Expected colon" };
-        }
-        cursor++;
-
-        skipWhitespace(source, cursor);
-
-        if (cursor >= source.size()) {
-            return Error { cursor, "Expected value" };
-        }
-
-        auto value = parseValue(source, cursor, memRes);
-        if (!value) {
-            return value.error();
-        }
-        obj.emplace(std::move(*key), std::move(*value));
-
-        const auto separatorFound = skipSeparator(source, cursor);
-        if (cursor < source.size() && source[cursor] == '}') {
-            cursor++;
-            break;
-        }
-
-        if (!separatorFound) {
-            return Error { cursor, "Expected separator" };
-        }
-    }
-    return JsonValue(obj);
-}
-
-Result<JsonValue> parseValue(
-    std::string_view source, size_t& cursor, std::pmr::memory_resource* memRes)
-{
-    skipWhitespace(source, cursor);
-    if (cursor >= source.size()) {
-        return Error { cursor, "Expected value" };
-        ;
-    }
-
-    if (source[cursor] == '{') {
-        cursor++;
-        auto res = parseObject(source, cursor, memRes);
-        if (!res) {
-            return res.error();
-        }
-        return res;
-    } else if (source[cursor] == '[') {
-        cursor++;
-        auto res = parseArray(source, cursor, memRes);
-        if (!res) {
-            return res.error();
-        }
-        return res;
-    } else if (source[cursor] == '"') {
-        auto res = parseString(source, cursor, memRes);
-        if (!res) {
-            return res.error();
-        }
-        return JsonValue(std::move(*res));
-    } else {
-        // null, bool or number
-        const auto valueChars = "0123456789abcdefghijlmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.+-";
-        auto valueEnd = source.find_first_not_of(valueChars, cursor);
-        if (valueEnd == std::string_view::npos) {
-            valueEnd = source.size();
-        }
-        const auto value = source.substr(cursor, valueEnd - cursor);
-        if (value.empty()) {
-            return Error { cursor, "Value must not be empty" };
-            ;
-        }
-
-        if (value == "null") {
-            cursor += value.size();
-            return JsonValue(JsonValue::Null {});
-        } else if (value == "true") {
-            cursor += value.size();
-            return JsonValue(true);
-        } else if (value == "false") {
-            cursor += value.size();
-            return JsonValue(false);
-        }
-
-        auto number = parseNumber(value);
-        if (!number) {
-            return Error { cursor, "Invalid number" };
-        }
-        cursor += value.size();
-        return JsonValue(*number);
-    }
-}
-}
+#include "minijson_sax.hpp"
+#include "minijson_writer.hpp"
 
 namespace minijson {
 size_t JsonValue::size() const
@@ -286,68 +44,61 @@ const JsonValue& JsonValue::operator[](size_t index) const
     }
 }
 
-std::string JsonValue::dump(std::string_view indent, size_t indentLevel) const
+JsonValue* JsonValue::find(std::string_view key)
 {
-    std::string indentStr;
-    indentStr.reserve(indent.size() * indentLevel);
-    for (size_t i = 0; i < indentLevel; ++i) {
-        indentStr.append(indent);
+    if (const auto obj = to<Object>()) {
+        const auto it = obj->find(key);
+        return it == obj->end() ? nullptr : &it->second;
     }
+    return nullptr;
+}
 
-    assert(isValid());
-    switch (type()) {
-    case Type::Null:
-        return "null";
-    case Type::Bool:
-        return asBool() ? "true" : "false";
-    case Type::Number:
-        return std::to_string(asNumber());
-    case Type::String:
-        // TODO: Escape characters
-        return std::string("\"" + asString() + "\"");
-    case Type::Array: {
-        std::string ret = "[\n";
-        const auto& arr = asArray();
-        for (size_t i = 0; i < arr.size(); ++i) {
-            ret.append(indentStr);
-            ret.append(indent);
-            ret.append(arr[i].dump(indent, indentLevel + 1));
-            if (i < arr.size() - 1) {
-                ret.append(",");
-            }
-            ret.append("\n");
-        }
-        ret.append(indentStr);
-        ret.append("]");
-        return ret;
+JsonValue* JsonValue::find(size_t index)
+{
+    if (const auto array = to<Array>(); array && index < array->size()) {
+        return &(*array)[index];
     }
-    case Type::Object: {
-        std::string ret = "{\n";
-        size_t idx = 0;
-        const auto& obj = asObject();
-        for (const auto& [key, value] : obj) {
-            ret.append(indentStr);
-            ret.append(indent);
-            ret.append("\"");
-            ret.append(key);
-            ret.append("\": ");
-            ret.append(value.dump(indent, indentLevel + 1));
-            if (idx < obj.size() - 1) {
-                ret.append(",");
+    return nullptr;
+}
+
+void JsonValue::moveTo(std::pmr::memory_resource* memRes)
+{
+    if (const auto str = to<String>()) {
+        str->moveTo(memRes);
+    } else if (auto array = to<Array>()) {
+        if (*array->get_allocator().resource() != *memRes) {
+            // Not assigned, which would move the elements back to the old resource
+            Array moved(std::move(*array), memRes);
+            array = &value_.emplace<Array>(std::move(moved));
+        }
+        for (auto& element : *array) {
+            element.moveTo(memRes);
+        }
+    } else if (auto object = to<Object>()) {
+        if (*object->memoryResource() != *memRes) {
+            Object moved(memRes);
+            moved.reserve(object->size());
+            for (auto& [key, value] : *object) {
+                moved.emplace(std::move(key), std::move(value));
             }
-            idx++;
-            ret.append("\n");
+            object = &value_.emplace<Object>(std::move(moved));
+        }
+        for (auto& [key, value] : *object) {
+            key.moveTo(memRes);
+            value.moveTo(memRes);
         }
-        ret.append(indentStr);
-        ret.append("}");
-        return ret;
-    }
-    default:
-        assert(false && "Invalid JsonValue type");
-        return "";
     }
 }
 
+std::string JsonValue::dump(std::string_view indent, size_t indentLevel) const
+{
+    WriteOptions options;
+    options.pretty = true;
+    options.indent = indent;
+    options.indentLevel = indentLevel;
+    return minijson::toString(*this, options);
+}
+
 const JsonValue& JsonValue::getNonExistent()
 {
     static JsonValue v;
@@ -356,7 +107,10 @@ const JsonValue& JsonValue::getNonExistent()
 
 std::string getContext(std::string_view str, size_t cursor)
 {
+    cursor = std::min(cursor, str.size());
     size_t lineStart = cursor;
+    if (lineStart == str.size() && lineStart > 0)
+        lineStart--;
     while (lineStart > 0 && str[lineStart] != '\n')
         lineStart--;
     if (lineStart < cursor && str[lineStart] == '\n')
@@ -370,9 +124,157 @@ std::string getContext(std::string_view str, size_t cursor)
         + std::string(cursor - lineStart, ' ') + "^";
 }
 
-Result<JsonValue> parse(std::string_view source, std::pmr::memory_resource* memRes)
+const char* getMessage(ErrorCode code)
+{
+    switch (code) {
+    case ErrorCode::None:
+        return "No error";
+    case ErrorCode::ExpectedValue:
+        return "Expected value";
+    case ErrorCode::InvalidLiteral:
+        return "Invalid literal";
+    case ErrorCode::InvalidNumber:
+        return "Invalid number";
+    case ErrorCode::UnterminatedString:
+        return "Unterminated string";
+    case ErrorCode::InvalidEscape:
+        return "Invalid character escape";
+    case ErrorCode::InvalidUnicodeEscape:
+        return "Invalid Unicode escape";
+    case ErrorCode::InvalidUtf8:
+        return "Invalid UTF-8";
+    case ErrorCode::ControlCharacter:
+        return "Unescaped control character in string";
+    case ErrorCode::ExpectedKey:
+        return "Expected key";
+    case ErrorCode::ExpectedColon:
+        return "Expected colon";
+    case ErrorCode::ExpectedSeparator:
+        return "Expected separator";
+    case ErrorCode::TrailingComma:
+        return "Trailing comma";
+    case ErrorCode::UnterminatedArray:
+        return "Unterminated array";
+    case ErrorCode::UnterminatedObject:
+        return "Unterminated object";
+    case ErrorCode::MaxDepthExceeded:
+        return "Maximum nesting depth exceeded";
+    case ErrorCode::TrailingCharacters:
+        return "Unexpected characters after value";
+    case ErrorCode::StoppedByHandler:
+        return "Stopped by handler";
+    case ErrorCode::ExpectedBool:
+        return "Expected bool";
+    case ErrorCode::ExpectedInteger:
+        return "Expected integer";
+    case ErrorCode::ExpectedNumber:
+        return "Expected number";
+    case ErrorCode::ExpectedString:
+        return "Expected string";
+    case ErrorCode::ExpectedArray:
+        return "Expected array";
+    case ErrorCode::ExpectedObject:
+        return "Expected object";
+    case ErrorCode::InvalidPointer:
+        return "Invalid JSON Pointer";
+    case ErrorCode::SourceTooLarge:
+        return "Source is too large";
+    case ErrorCode::InvalidBinaryTape:
+        return "Invalid binary tape";
+    case ErrorCode::CouldNotOpenFile:
+        return "Could not open file";
+    case ErrorCode::CouldNotGetFileSize:
+        return "Could not get file size";
+    case ErrorCode::CouldNotMapFile:
+        return "Could not map file";
+    case ErrorCode::CouldNotWriteFile:
+        return "Could not write file";
+    }
+    return "Unknown error";
+}
+
+Location getLocation(std::string_view source, size_t cursor)
+{
+    cursor = std::min(cursor, source.size());
+    Location location { 1, cursor + 1 };
+    auto pos = source.find('\n');
+    while (pos < cursor) {
+        location.line++;
+        location.column = cursor - pos;
+        pos = source.find('\n', pos + 1);
+    }
+    return location;
+}
+
+std::string Error::message() const
+{
+    std::string msg = getMessage(code);
+    if (systemError != 0) {
+        msg += std::string(": ") + std::strerror(systemError);
+    }
+    return msg;
+}
+
+std::string Error::describe(std::string_view source) const
+{
+    const auto location = getLocation(source, cursor);
+    return message() + " at line " + std::to_string(location.line) + ", column "
+        + std::to_string(location.column) + "\n" + getContext(source, cursor);
+}
+
+std::ostream& operator<<(std::ostream& stream, const String& str)
 {
-    size_t cursor = 0;
-    return parseValue(source, cursor, memRes);
+    return stream << str.view();
+}
+
+Result<JsonValue> parse(
+    std::string_view source, std::pmr::memory_resource* memRes, const ParseOptions& options)
+{
+    DomBuilder builder(source, memRes, options);
+    // Generic, so the allocation counting is discarded without stats
+    const auto res = detail::withStats(options, [&](auto* stats) {
+        if constexpr (detail::statsEnabled) {
+            const auto counting = stats ? dynamic_cast<CountingResource*>(memRes) : nullptr;
+            const auto allocations = counting ? counting->allocations() : 0;
+            const auto allocatedBytes = counting ? counting->allocatedBytes() : 0;
+            auto res = detail::runSax(source, builder, options, stats);
+            if (counting) {
+                stats->allocations = counting->allocations() - allocations;
+                stats->allocatedBytes = counting->allocatedBytes() - allocatedBytes;
+            }
+            return res;
+        } else {
+            return detail::runSax(source, builder, options, stats);
+        }
+    });
+    if (!res) {
+        return res.error();
+    }
+    const auto end = detail::findNonWhitespace(source.data(), source.size(), *res);
+    if (end < source.size()) {
+        return Error { ErrorCode::TrailingCharacters, end };
+    }
+    return std::move(builder.root());
+}
+
+Result<JsonValue> parse(
+    std::string_view source, const ParseOptions& options, std::pmr::memory_resource* memRes)
+{
+    return parse(source, memRes, options);
+}
+
+std::optional<Error> parseInto(JsonValue& target, std::string_view source,
+    std::pmr::memory_resource* memRes, const ParseOptions& options)
+{
+    detail::ReuseBuilder builder(target, source, memRes, options);
+    const auto res = parseSax(source, builder, options);
+    if (!res) {
+        return res.error();
+    }
+    const auto end = detail::findNonWhitespace(source.data(), source.size(), *res);
+    if (end < source.size()) {
+        return Error { ErrorCode::TrailingCharacters, end };
+    }
+    return std::nullopt;
 }
 }
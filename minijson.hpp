@@ -1,24 +1,351 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iosfwd>
 #include <memory_resource>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
+#include "minijson_hashindex.hpp"
+
 namespace minijson {
+class KeyInterner;
+struct ParseStats;
+
+namespace detail {
+    class ReuseBuilder;
+}
+
+// Either owns its characters or refers to characters owned by someone else (see
+// ParseOptions::zeroCopyStrings). In the latter case whoever owns them has to keep them alive.
+class String {
+public:
+    String() = default;
+    String(const char* str) : value_(std::pmr::string(str)) { }
+    String(std::string_view str,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+        : value_(std::pmr::string(str, memRes))
+    {
+    }
+    String(std::pmr::string str) : value_(std::move(str)) { }
+
+    // Does not copy `str`
+    static String ref(std::string_view str)
+    {
+        String s;
+        s.value_ = str;
+        return s;
+    }
+
+    bool isRef() const { return value_.index() == 1; }
+
+    // Copies `str`, but keeps the characters (and their memory resource) if this already owns
+    // some, so their capacity is reused
+    void assign(std::string_view str,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+    {
+        if (const auto owned = std::get_if<std::pmr::string>(&value_)) {
+            owned->assign(str);
+        } else {
+            value_ = std::pmr::string(str, memRes);
+        }
+    }
+
+    // Copies owned characters to memRes unless they are allocated from it already. References
+    // stay references.
+    void moveTo(std::pmr::memory_resource* memRes)
+    {
+        const auto owned = std::get_if<std::pmr::string>(&value_);
+        if (owned && *owned->get_allocator().resource() != *memRes) {
+            value_ = std::pmr::string(*owned, memRes);
+        }
+    }
+
+    std::string_view view() const
+    {
+        if (const auto ref = std::get_if<std::string_view>(&value_)) {
+            return *ref;
+        }
+        return std::get<std::pmr::string>(value_);
+    }
+
+    operator std::string_view() const { return view(); }
+
+    const char* data() const { return view().data(); }
+    size_t size() const { return view().size(); }
+    bool empty() const { return view().empty(); }
+
+    // The templates take anything that converts to std::string_view (const char*, std::string,
+    // ...) without introducing ambiguities with the String overloads.
+    template <typename T>
+    using EnableIfStringLike
+        = std::enable_if_t<std::is_convertible_v<const T&, std::string_view>, bool>;
+
+    // Goes through assign, so the characters stay with the resource they are allocated from
+    template <typename T, EnableIfStringLike<T> = true>
+    String& operator=(const T& str)
+    {
+        assign(str);
+        return *this;
+    }
+
+    // Interned keys share their characters, so they are equal without comparing them
+    friend bool operator==(const String& a, const String& b)
+    {
+        const auto av = a.view();
+        const auto bv = b.view();
+        return av.size() == bv.size() && (av.data() == bv.data() || av == bv);
+    }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator==(const String& a, const T& b)
+    {
+        return a.view() == std::string_view(b);
+    }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator==(const T& a, const String& b)
+    {
+        return std::string_view(a) == b.view();
+    }
+
+    friend bool operator!=(const String& a, const String& b) { return !(a == b); }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator!=(const String& a, const T& b)
+    {
+        return !(a == b);
+    }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator!=(const T& a, const String& b)
+    {
+        return !(a == b);
+    }
+
+    friend bool operator<(const String& a, const String& b) { return a.view() < b.view(); }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator<(const String& a, const T& b)
+    {
+        return a.view() < std::string_view(b);
+    }
+    template <typename T, EnableIfStringLike<T> = true>
+    friend bool operator<(const T& a, const String& b)
+    {
+        return std::string_view(a) < b.view();
+    }
+
+private:
+    std::variant<std::pmr::string, std::string_view> value_;
+};
+
+std::ostream& operator<<(std::ostream& stream, const String& str);
+
+// A flat object, which keeps its members in insertion (i.e. document) order.
+// Small objects are searched linearly, larger ones get a hash index on top.
+// `Value` is a template parameter, so it may be incomplete when the object type is declared.
+template <typename Value>
+class BasicObject {
+public:
+    using value_type = std::pair<String, Value>;
+    using Members = std::pmr::vector<value_type>;
+    using iterator = typename Members::iterator;
+    using const_iterator = typename Members::const_iterator;
+
+    // Objects with more members than this get a hash index
+    static constexpr size_t hashThreshold = 16;
+
+    BasicObject(std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+        : members_(memRes), index_(memRes)
+    {
+    }
+
+    BasicObject(std::initializer_list<value_type> init,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+        : BasicObject(memRes)
+    {
+        members_.reserve(init.size());
+        for (const auto& member : init) {
+            emplace(member.first, member.second);
+        }
+    }
+
+    iterator begin() { return members_.begin(); }
+    iterator end() { return members_.end(); }
+    const_iterator begin() const { return members_.begin(); }
+    const_iterator end() const { return members_.end(); }
+
+    size_t size() const { return members_.size(); }
+    bool empty() const { return members_.empty(); }
+    void reserve(size_t n) { members_.reserve(n); }
+
+    // Keys that are added by try_emplace and insert_or_assign are copied with this
+    std::pmr::memory_resource* memoryResource() const
+    {
+        return members_.get_allocator().resource();
+    }
+
+    const_iterator find(std::string_view key) const { return begin() + findIndex(key); }
+    iterator find(std::string_view key) { return begin() + findIndex(key); }
+
+    // For repeated lookups of the same key. `hash` has to be hashKey(key).
+    static size_t hashKey(std::string_view key) { return std::hash<std::string_view>()(key); }
+    const_iterator find(std::string_view key, size_t hash) const
+    {
+        return begin() + (index_.empty() ? findLinear(key) : findHashed(key, hash));
+    }
+
+    // Like std::map::emplace this does nothing if the key already exists
+    std::pair<iterator, bool> emplace(String key, Value value)
+    {
+        const auto idx = findIndex(key);
+        if (idx < members_.size()) {
+            return { begin() + idx, false };
+        }
+        members_.emplace_back(std::move(key), std::move(value));
+        indexLast(members_.size());
+        return { end() - 1, true };
+    }
+
+    // Like std::map::try_emplace the value is only constructed (in place) if the key doesn't
+    // exist yet
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args&&... args)
+    {
+        const auto idx = findIndex(key);
+        if (idx < members_.size()) {
+            return { begin() + idx, false };
+        }
+        members_.emplace_back(std::piecewise_construct,
+            std::forward_as_tuple(key, memoryResource()),
+            std::forward_as_tuple(std::forward<Args>(args)...));
+        indexLast(members_.size());
+        return { end() - 1, true };
+    }
+
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, Value value)
+    {
+        auto res = try_emplace(key, std::move(value));
+        if (!res.second) {
+            // try_emplace doesn't touch the value if the key exists
+            res.first->second = std::move(value);
+        }
+        return res;
+    }
+
+    // Keeps the order of the other members, so this is linear in the size of the object
+    iterator erase(const_iterator pos)
+    {
+        const auto it = members_.erase(pos);
+        if (members_.size() > hashThreshold) {
+            rebuildIndex(members_.size());
+        } else {
+            index_.clear();
+        }
+        return it;
+    }
+
+    // Returns the number of members that were removed (0 or 1)
+    size_t erase(std::string_view key)
+    {
+        const auto it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        members_.clear();
+        index_.clear();
+    }
+
+private:
+    // Refills objects in place (see parseInto)
+    friend class detail::ReuseBuilder;
+
+    // Keys from the same KeyInterner are equal if they are the same characters
+    static bool keyEquals(std::string_view a, std::string_view b)
+    {
+        return a.size() == b.size() && (a.data() == b.data() || a == b);
+    }
+
+    size_t findIndex(std::string_view key) const
+    {
+        return index_.empty() ? findLinear(key) : findHashed(key, hashKey(key));
+    }
+
+    // Only the first `count` members are searched
+    size_t findLinear(std::string_view key, size_t count) const
+    {
+        for (size_t i = 0; i < count; ++i) {
+            if (keyEquals(members_[i].first.view(), key)) {
+                return i;
+            }
+        }
+        return members_.size();
+    }
+
+    size_t findLinear(std::string_view key) const { return findLinear(key, members_.size()); }
+
+    size_t findHashed(std::string_view key, size_t hash) const
+    {
+        return index_.find(
+            hash,
+            [&](size_t idx) { return keyEquals(members_[idx].first.view(), key); },
+            members_.size());
+    }
+
+    void insertIndex(size_t idx)
+    {
+        index_.insert(hashKey(members_[idx].first.view()), static_cast<uint32_t>(idx));
+    }
+
+    // Only the first `count` members are indexed
+    void rebuildIndex(size_t count)
+    {
+        index_.reset(count);
+        for (size_t i = 0; i < count; ++i) {
+            insertIndex(i);
+        }
+    }
+
+    // Adds the last of the first `count` members to the index, if there is one or should be one
+    void indexLast(size_t count)
+    {
+        if (!index_.empty()) {
+            if (index_.isFull(count)) {
+                rebuildIndex(count);
+            } else {
+                insertIndex(count - 1);
+            }
+        } else if (count > hashThreshold) {
+            rebuildIndex(count);
+        }
+    }
+
+    Members members_;
+    detail::HashIndex index_;
+};
+
 class JsonValue {
 public:
     struct Invalid { };
     struct Null { };
     using Bool = bool;
     using Number = double;
-    using String = std::pmr::string;
+    // Integers are parsed into these if they fit, so they don't lose precision
+    using Int = int64_t;
+    // Only for integers that do not fit into Int
+    using UInt = uint64_t;
+    using String = minijson::String;
     using Array = std::pmr::vector<JsonValue>;
-    // map instead of unordered_map, because it supports incomplete value types
-    // We need a transparent comparator to enable .find with std::string_view
-    using Object = std::pmr::map<std::pmr::string, JsonValue, std::less<>>;
+    using Object = BasicObject<JsonValue>;
 
     enum class Type {
         Invalid = 0,
@@ -34,13 +361,51 @@ public:
     JsonValue(Null n) : value_(std::move(n)) { } // better move that empty struct! #highperformance
     JsonValue(bool b) : value_(b) { }
     JsonValue(double v) : value_(v) { }
+    JsonValue(int v) : value_(Int(v)) { } // Avoid ambiguities for literals
+    JsonValue(Int v) : value_(v) { }
+    JsonValue(UInt v) : value_(v) { }
     JsonValue(String s) : value_(std::move(s)) { }
     JsonValue(Array v) : value_(std::move(v)) { }
     JsonValue(Object m) : value_(std::move(m)) { }
+    // Constructs the alternative T (e.g. an Array with a memory resource) in place
+    template <typename T, typename... Args>
+    explicit JsonValue(std::in_place_type_t<T> type, Args&&... args)
+        : value_(type, std::forward<Args>(args)...)
+    {
+    }
+
+    // Empty containers and strings that allocate from memRes (e.g. Document::memoryResource())
+    static JsonValue makeArray(std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+    {
+        return JsonValue(std::in_place_type<Array>, memRes);
+    }
+    static JsonValue makeObject(
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+    {
+        return JsonValue(std::in_place_type<Object>, memRes);
+    }
+    static JsonValue makeString(std::string_view str,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource())
+    {
+        return JsonValue(std::in_place_type<String>, str, memRes);
+    }
+
+    // Replaces the value with a T constructed in place
+    template <typename T, typename... Args>
+    T& emplace(Args&&... args)
+    {
+        return value_.template emplace<T>(std::forward<Args>(args)...);
+    }
 
     // This is a bit brittle, but if we are being honest, doing a switch is not super robust either.
     // I have messed that up before too.
-    Type type() const { return static_cast<Type>(value_.index()); }
+    // Int and UInt are numbers too, they are just stored exactly.
+    Type type() const
+    {
+        constexpr Type types[] = { Type::Invalid, Type::Null, Type::Bool, Type::Number,
+            Type::String, Type::Array, Type::Object, Type::Number, Type::Number };
+        return types[value_.index()];
+    }
 
     template <typename T>
     bool is() const
@@ -50,8 +415,12 @@ public:
 
     bool isValid() const { return !is<Invalid>(); }
     bool isNull() const { return is<Null>(); }
-    bool isBool() { return is<Bool>(); }
-    bool isNumber() const { return is<Number>(); }
+    bool isBool() const { return is<Bool>(); }
+    // Number, Int or UInt
+    bool isNumber() const { return is<Number>() || isInteger(); }
+    bool isInteger() const { return is<Int>() || is<UInt>(); }
+    bool isInt() const { return is<Int>(); }
+    bool isUInt() const { return is<UInt>(); }
     bool isString() const { return is<String>(); }
     bool isArray() const { return is<Array>(); }
     bool isObject() const { return is<Object>(); }
@@ -65,27 +434,66 @@ public:
     {
         return std::get<T>(value_);
     }
+    template <typename T>
+    T& as()
+    {
+        return std::get<T>(value_);
+    }
 
     const Bool& asBool() const { return as<Bool>(); }
-    const Number& asNumber() const { return as<Number>(); }
+    // Converts Int and UInt, which might lose precision
+    Number asNumber() const
+    {
+        if (const auto i = std::get_if<Int>(&value_)) {
+            return static_cast<Number>(*i);
+        } else if (const auto u = std::get_if<UInt>(&value_)) {
+            return static_cast<Number>(*u);
+        }
+        return as<Number>();
+    }
+    const Int& asInt() const { return as<Int>(); }
+    const UInt& asUInt() const { return as<UInt>(); }
     const String& asString() const { return as<String>(); }
     const Array& asArray() const { return as<Array>(); }
     const Object& asObject() const { return as<Object>(); }
+    Bool& asBool() { return as<Bool>(); }
+    Int& asInt() { return as<Int>(); }
+    UInt& asUInt() { return as<UInt>(); }
+    String& asString() { return as<String>(); }
+    Array& asArray() { return as<Array>(); }
+    Object& asObject() { return as<Object>(); }
 
     template <typename T>
     const T* to() const
     {
-        if (is<T>()) {
-            return &as<T>();
-        }
-        return nullptr;
+        return std::get_if<T>(&value_);
+    }
+    template <typename T>
+    T* to()
+    {
+        return std::get_if<T>(&value_);
     }
 
     const Bool* toBool() const { return to<Bool>(); }
-    const Number* toNumber() const { return to<Number>(); }
+    // Converts like asNumber, so it can't return a pointer
+    std::optional<Number> toNumber() const
+    {
+        if (isNumber()) {
+            return asNumber();
+        }
+        return std::nullopt;
+    }
+    const Int* toInt() const { return to<Int>(); }
+    const UInt* toUInt() const { return to<UInt>(); }
     const String* toString() const { return to<String>(); }
     const Array* toArray() const { return to<Array>(); }
     const Object* toObject() const { return to<Object>(); }
+    Bool* toBool() { return to<Bool>(); }
+    Int* toInt() { return to<Int>(); }
+    UInt* toUInt() { return to<UInt>(); }
+    String* toString() { return to<String>(); }
+    Array* toArray() { return to<Array>(); }
+    Object* toObject() { return to<Object>(); }
 
     // 0 for null and invalid, number of elements for array and object, 1 otherwise
     size_t size() const;
@@ -94,17 +502,111 @@ public:
     const JsonValue& operator[](std::string_view key) const;
     const JsonValue& operator[](size_t index) const;
 
+    // Like operator[], but for changing the value. nullptr if the key/index does not exist.
+    JsonValue* find(std::string_view key);
+    JsonValue* find(size_t index);
+
+    // Copies strings, arrays and objects (recursively) that are not allocated from memRes there,
+    // so they are freed together with it. Referenced strings stay references.
+    void moveTo(std::pmr::memory_resource* memRes);
+
+    // For arrays. The new element is moved to the array's resource (see moveTo), so it is freed
+    // together with the array, even if that is an arena that never runs destructors.
+    template <typename... Args>
+    JsonValue& emplaceBack(Args&&... args)
+    {
+        auto& array = asArray();
+        auto& element = array.emplace_back(std::forward<Args>(args)...);
+        element.moveTo(array.get_allocator().resource());
+        return element;
+    }
+
+    // For objects. Adds the member or replaces its value. The key is copied with the object's
+    // resource and the value is moved to it.
+    JsonValue& set(std::string_view key, JsonValue value)
+    {
+        auto& object = asObject();
+        value.moveTo(object.memoryResource());
+        return object.insert_or_assign(key, std::move(value)).first->second;
+    }
+
+    // For objects. Returns whether there was such a member.
+    bool erase(std::string_view key) { return asObject().erase(key) > 0; }
+
     std::string dump(std::string_view indent = "", size_t indentLevel = 0) const;
 
 private:
+    // Builds values in place
+    friend class DomBuilder;
+    friend class detail::ReuseBuilder;
+
     static const JsonValue& getNonExistent(); // returns a static invalid JsonValue
 
-    std::variant<Invalid, Null, Bool, Number, String, Array, Object> value_;
+    // Keep the order in sync with type()
+    std::variant<Invalid, Null, Bool, Number, String, Array, Object, Int, UInt> value_;
 };
 
+// Why parsing (or anything else that returns an Error) failed
+enum class ErrorCode {
+    None,
+    ExpectedValue,
+    InvalidLiteral,
+    InvalidNumber,
+    UnterminatedString,
+    InvalidEscape,
+    // Not four hex digits or an unpaired surrogate
+    InvalidUnicodeEscape,
+    InvalidUtf8,
+    // Control characters (< 0x20) have to be escaped in strings (only checked by validate)
+    ControlCharacter,
+    ExpectedKey,
+    ExpectedColon,
+    ExpectedSeparator,
+    TrailingComma,
+    UnterminatedArray,
+    UnterminatedObject,
+    MaxDepthExceeded,
+    TrailingCharacters,
+    StoppedByHandler,
+    // A value didn't fit the type it is bound to (see minijson_bind.hpp)
+    ExpectedBool,
+    ExpectedInteger,
+    ExpectedNumber,
+    ExpectedString,
+    ExpectedArray,
+    ExpectedObject,
+    InvalidPointer,
+    SourceTooLarge,
+    // A binary tape with a wrong header or inconsistent entries (see minijson_binary.hpp)
+    InvalidBinaryTape,
+    // File errors, which set Error::systemError
+    CouldNotOpenFile,
+    CouldNotGetFileSize,
+    CouldNotMapFile,
+    CouldNotWriteFile,
+};
+
+const char* getMessage(ErrorCode code);
+
+// Both start at 1. Columns count bytes.
+struct Location {
+    size_t line;
+    size_t column;
+};
+
+Location getLocation(std::string_view source, size_t cursor);
+
+// Errors are cheap to create and copy. Their messages are only formatted when asked for.
 struct Error {
-    size_t cursor;
-    std::string message;
+    ErrorCode code = ErrorCode::None;
+    // In the source
+    size_t cursor = 0;
+    // The errno of a failed system call
+    int systemError = 0;
+
+    std::string message() const;
+    // Includes the location and the context (see getContext) of the cursor in `source`
+    std::string describe(std::string_view source) const;
 };
 
 template <typename T>
@@ -123,8 +625,43 @@ private:
     std::variant<T, Error> value;
 };
 
+struct ParseOptions {
+    // Strings (and keys) without escapes will refer to the source instead of being copied.
+    // The source then has to outlive the parse result.
+    bool zeroCopyStrings = false;
+    // Deeper nesting is an error. The parser itself doesn't need the stack, but destroying and
+    // dumping a JsonValue is recursive.
+    size_t maxDepth = 1024;
+    // Keys are looked up in (or added to) this and refer to the stored copy instead of being
+    // copied into every object. It has to outlive the parse result. Use the same one for many
+    // parses (e.g. of a Document) to share the keys between them. Frozen interners can be shared
+    // between threads and keys that they don't have are copied as usual. This takes precedence
+    // over zeroCopyStrings for keys.
+    KeyInterner* keyInterner = nullptr;
+    // Filled with the statistics of the parse if the library is built with MINIJSON_ENABLE_STATS
+    // (see minijson_stats.hpp), otherwise untouched. Not used by parseNdjson and the elements of
+    // a ParallelDocument, which are parsed concurrently.
+    ParseStats* stats = nullptr;
+    // Fail with ErrorCode::InvalidUtf8 if a string or key is not valid UTF-8. Escapes always
+    // decode to valid UTF-8. Everything outside of strings is ASCII anyway.
+    bool validateUtf8 = false;
+};
+
 std::string getContext(std::string_view str, size_t cursor);
 
-Result<JsonValue> parse(
-    std::string_view source, std::pmr::memory_resource* memRes = std::pmr::get_default_resource());
+// The source has to be a single value, which may be surrounded by whitespace
+Result<JsonValue> parse(std::string_view source,
+    std::pmr::memory_resource* memRes = std::pmr::get_default_resource(),
+    const ParseOptions& options = {});
+Result<JsonValue> parse(std::string_view source, const ParseOptions& options,
+    std::pmr::memory_resource* memRes = std::pmr::get_default_resource());
+
+// Like parse, but overwrites `target` in place. Arrays, objects and strings that are already in
+// the same place of `target` are reused along with their capacity, so parsing documents of the
+// same shape over and over eventually stops allocating. Anything else is allocated from memRes,
+// which should be the resource that `target` was built with (if it isn't empty), because reused
+// values keep their resource. On error `target` holds a partial document.
+std::optional<Error> parseInto(JsonValue& target, std::string_view source,
+    std::pmr::memory_resource* memRes = std::pmr::get_default_resource(),
+    const ParseOptions& options = {});
 }
@@ -0,0 +1,124 @@
+#include "minijson_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace {
+constexpr size_t chunkAlignment = alignof(std::max_align_t);
+}
+
+namespace minijson {
+Arena::Arena(size_t initialSize, std::pmr::memory_resource* upstream)
+    : upstream_(upstream)
+    , nextSize_(std::max(initialSize, sizeof(Chunk) + 64))
+{
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+void Arena::addChunk(size_t minSize)
+{
+    Chunk* chunk;
+    if (spare_ && spare_->size >= minSize + sizeof(Chunk)) {
+        chunk = std::exchange(spare_, nullptr);
+    } else {
+        const auto size = std::max(nextSize_, minSize + sizeof(Chunk));
+        chunk = static_cast<Chunk*>(upstream_->allocate(size, chunkAlignment));
+        chunk->size = size;
+        capacity_ += size;
+    }
+    const auto size = chunk->size;
+    chunk->next = chunks_;
+    chunks_ = chunk;
+    cursor_ = reinterpret_cast<char*>(chunk) + sizeof(Chunk);
+    end_ = reinterpret_cast<char*>(chunk) + size;
+    nextSize_ = std::max(nextSize_, size * 2);
+}
+
+void Arena::reserve(size_t bytes)
+{
+    if (static_cast<size_t>(end_ - cursor_) < bytes) {
+        // The rest of the current chunk is wasted, but that's what reserve is for
+        nextSize_ = std::max(nextSize_, bytes + sizeof(Chunk));
+        addChunk(bytes);
+    }
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment)
+{
+    auto addr = reinterpret_cast<uintptr_t>(cursor_);
+    auto aligned = (addr + alignment - 1) & ~(alignment - 1);
+    if (!cursor_ || aligned + bytes > reinterpret_cast<uintptr_t>(end_)) {
+        addChunk(bytes + alignment);
+        addr = reinterpret_cast<uintptr_t>(cursor_);
+        aligned = (addr + alignment - 1) & ~(alignment - 1);
+    }
+    cursor_ = reinterpret_cast<char*>(aligned + bytes);
+    return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::reset()
+{
+    if (!chunks_) {
+        return;
+    }
+    if (chunks_->next) {
+        const auto total = capacity_;
+        release();
+        nextSize_ = total;
+        addChunk(0);
+    } else {
+        cursor_ = reinterpret_cast<char*>(chunks_) + sizeof(Chunk);
+    }
+}
+
+Arena::Checkpoint Arena::checkpoint() const
+{
+    Checkpoint checkpoint;
+    checkpoint.chunk = chunks_;
+    checkpoint.cursor = cursor_;
+    return checkpoint;
+}
+
+void Arena::rewind(const Checkpoint& checkpoint)
+{
+    while (chunks_ != checkpoint.chunk) {
+        auto chunk = chunks_;
+        chunks_ = chunk->next;
+        if (!spare_) {
+            spare_ = chunk;
+            continue;
+        }
+        // Keeps the larger one
+        if (spare_->size < chunk->size) {
+            std::swap(spare_, chunk);
+        }
+        capacity_ -= chunk->size;
+        upstream_->deallocate(chunk, chunk->size, chunkAlignment);
+    }
+    cursor_ = checkpoint.cursor;
+    end_ = chunks_ ? reinterpret_cast<char*>(chunks_) + chunks_->size : nullptr;
+}
+
+void Arena::release()
+{
+    auto chunk = chunks_;
+    while (chunk) {
+        const auto next = chunk->next;
+        upstream_->deallocate(chunk, chunk->size, chunkAlignment);
+        chunk = next;
+    }
+    if (spare_) {
+        upstream_->deallocate(spare_, spare_->size, chunkAlignment);
+    }
+    chunks_ = nullptr;
+    spare_ = nullptr;
+    cursor_ = nullptr;
+    end_ = nullptr;
+    capacity_ = 0;
+}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace minijson {
+// A bump allocator that gets memory from upstream in growing chunks. Deallocation is a no-op and
+// everything is freed at once. Unlike std::pmr::monotonic_buffer_resource it can be reset without
+// giving the memory back, so it can be reused for many parses. Not thread-safe.
+class Arena : public std::pmr::memory_resource {
+public:
+    // Position in the arena to go back to with rewind()
+    class Checkpoint {
+    private:
+        friend class Arena;
+
+        const void* chunk = nullptr;
+        char* cursor = nullptr;
+    };
+
+    explicit Arena(size_t initialSize = 4096,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Makes sure the next `bytes` bytes can be allocated without going upstream
+    void reserve(size_t bytes);
+
+    // Makes all memory available again, but keeps it. If there is more than one chunk, they are
+    // merged into a single one, so the next use of the same size only needs one chunk.
+    void reset();
+
+    // Gives all memory back to upstream
+    void release();
+
+    // Frees everything that was allocated since the checkpoint was taken, which must not be older
+    // than the last reset() or release(). Chunks that were added since are given back to upstream,
+    // except for the largest one, which is kept for the next chunk that is needed.
+    Checkpoint checkpoint() const;
+    void rewind(const Checkpoint& checkpoint);
+
+    // Bytes allocated from upstream
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t size; // including this header
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override { }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void addChunk(size_t minSize);
+
+    std::pmr::memory_resource* upstream_;
+    size_t nextSize_;
+    size_t capacity_ = 0;
+    // The current chunk is the first one
+    Chunk* chunks_ = nullptr;
+    // Left over from rewind()
+    Chunk* spare_ = nullptr;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+};
+}
@@ -0,0 +1,241 @@
+#include "minijson_binary.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace minijson;
+
+namespace {
+constexpr char magic[4] = { 'M', 'J', 'T', '1' };
+constexpr uint32_t byteOrderMark = 0x01020304;
+
+struct Header {
+    char magic[4];
+    uint32_t byteOrder;
+    uint64_t numEntries;
+    uint64_t stringsSize;
+};
+static_assert(sizeof(Header) == 24 && sizeof(Header) % sizeof(uint64_t) == 0);
+
+Header makeHeader(const Tape& tape)
+{
+    Header header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.byteOrder = byteOrderMark;
+    header.numEntries = tape.numEntries();
+    header.stringsSize = tape.stringsSize();
+    return header;
+}
+
+Error makeError(size_t cursor)
+{
+    return Error { ErrorCode::InvalidBinaryTape, cursor };
+}
+
+TapeTag getTag(uint64_t entry)
+{
+    return static_cast<TapeTag>(entry >> 56);
+}
+
+uint64_t getPayload(uint64_t entry)
+{
+    return entry & 0x00ff'ffff'ffff'ffff;
+}
+
+// Returns the index of the first entry that is inconsistent with the format described in
+// minijson_tape.hpp (or the start of a container that is not closed) or numEntries if there is
+// none.
+size_t findInvalidEntry(const TapeView& tape)
+{
+    struct Container {
+        size_t start;
+        uint64_t count;
+        bool object;
+        bool expectKey;
+    };
+    std::vector<Container> open;
+    const auto entries = tape.entries();
+    const auto numEntries = tape.numEntries();
+    bool seenRoot = false;
+    size_t i = 0;
+    while (i < numEntries) {
+        const auto tag = getTag(entries[i]);
+        const auto payload = getPayload(entries[i]);
+        const auto isEnd = tag == TapeTag::ArrayEnd || tag == TapeTag::ObjectEnd;
+        // Only a single root value
+        if (open.empty() && (seenRoot || isEnd)) {
+            return i;
+        }
+        seenRoot = true;
+
+        const auto parent = open.empty() ? nullptr : &open.back();
+        const auto isKey = parent && parent->object && parent->expectKey && !isEnd;
+        if (isKey && tag != TapeTag::String) {
+            return i;
+        }
+        if (parent && !isKey && !isEnd) {
+            parent->count++;
+            parent->expectKey = parent->object;
+        } else if (isKey) {
+            parent->expectKey = false;
+        }
+
+        switch (tag) {
+        case TapeTag::Null:
+        case TapeTag::True:
+        case TapeTag::False:
+            i++;
+            break;
+        case TapeTag::Number:
+        case TapeTag::Int:
+        case TapeTag::UInt:
+            if (i + 1 >= numEntries) {
+                return i;
+            }
+            i += 2;
+            break;
+        case TapeTag::String: {
+            uint32_t length;
+            if (payload > tape.stringsSize() || tape.stringsSize() - payload < sizeof(length)) {
+                return i;
+            }
+            std::memcpy(&length, tape.strings() + payload, sizeof(length));
+            if (tape.stringsSize() - payload - sizeof(length) < length) {
+                return i;
+            }
+            i++;
+            break;
+        }
+        case TapeTag::ArrayStart:
+        case TapeTag::ObjectStart:
+            open.push_back({ i, 0, tag == TapeTag::ObjectStart, tag == TapeTag::ObjectStart });
+            i++;
+            break;
+        case TapeTag::ArrayEnd:
+        case TapeTag::ObjectEnd: {
+            const auto container = open.back();
+            open.pop_back();
+            const auto startPayload = getPayload(entries[container.start]);
+            const auto count = startPayload >> 32;
+            const auto countMatches = count < detail::tapeMaxCount ? count == container.count
+                                                                   : container.count >= count;
+            // Objects can't end after a key
+            if (container.object != (tag == TapeTag::ObjectEnd)
+                || container.expectKey != container.object || payload != container.start
+                || (startPayload & 0xffff'ffff) != i + 1 || !countMatches) {
+                return i;
+            }
+            i++;
+            break;
+        }
+        default:
+            return i;
+        }
+    }
+    if (!open.empty()) {
+        return open.back().start;
+    }
+    return seenRoot ? numEntries : 0;
+}
+
+bool writeAll(int fd, const void* data, size_t size)
+{
+    auto bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const auto res = ::write(fd, bytes, size);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += res;
+        size -= static_cast<size_t>(res);
+    }
+    return true;
+}
+}
+
+namespace minijson {
+std::string encodeTape(const Tape& tape)
+{
+    const auto header = makeHeader(tape);
+    const auto entriesSize = tape.numEntries() * sizeof(uint64_t);
+    std::string blob(sizeof(Header) + entriesSize + tape.stringsSize(), '\0');
+    std::memcpy(blob.data(), &header, sizeof(Header));
+    std::memcpy(blob.data() + sizeof(Header), tape.entries(), entriesSize);
+    std::memcpy(blob.data() + sizeof(Header) + entriesSize, tape.strings(), tape.stringsSize());
+    return blob;
+}
+
+Result<TapeView> decodeTape(std::string_view blob, bool checkEntries)
+{
+    if (blob.size() < sizeof(Header)
+        || reinterpret_cast<uintptr_t>(blob.data()) % alignof(uint64_t) != 0) {
+        return makeError(0);
+    }
+    Header header;
+    std::memcpy(&header, blob.data(), sizeof(Header));
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        return makeError(offsetof(Header, magic));
+    }
+    if (header.byteOrder != byteOrderMark) {
+        return makeError(offsetof(Header, byteOrder));
+    }
+    const auto available = blob.size() - sizeof(Header);
+    if (header.numEntries > available / sizeof(uint64_t)) {
+        return makeError(offsetof(Header, numEntries));
+    }
+    const auto entriesSize = header.numEntries * sizeof(uint64_t);
+    if (header.stringsSize != available - entriesSize) {
+        return makeError(offsetof(Header, stringsSize));
+    }
+
+    TapeView view(reinterpret_cast<const uint64_t*>(blob.data() + sizeof(Header)),
+        header.numEntries, blob.data() + sizeof(Header) + entriesSize, header.stringsSize);
+    if (checkEntries) {
+        const auto invalid = findInvalidEntry(view);
+        if (invalid < view.numEntries() || view.numEntries() == 0) {
+            return makeError(sizeof(Header) + invalid * sizeof(uint64_t));
+        }
+    }
+    return view;
+}
+
+std::optional<Error> writeTapeFile(const Tape& tape, const std::string& path)
+{
+    const auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return Error { ErrorCode::CouldNotOpenFile, 0, errno };
+    }
+    // Written in pieces, so the tape isn't copied
+    const auto header = makeHeader(tape);
+    const auto written = writeAll(fd, &header, sizeof(Header))
+        && writeAll(fd, tape.entries(), tape.numEntries() * sizeof(uint64_t))
+        && writeAll(fd, tape.strings(), tape.stringsSize());
+    const auto error = errno;
+    if (::close(fd) != 0 || !written) {
+        return Error { ErrorCode::CouldNotWriteFile, 0, written ? errno : error };
+    }
+    return std::nullopt;
+}
+
+Result<MappedTape> openTapeFile(const std::string& path, bool checkEntries)
+{
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return file.error();
+    }
+    const auto view = decodeTape(file->view(), checkEntries);
+    if (!view) {
+        return view.error();
+    }
+    return MappedTape(std::move(*file), *view);
+}
+}
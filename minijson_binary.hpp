@@ -0,0 +1,47 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "minijson_file.hpp"
+#include "minijson_tape.hpp"
+
+namespace minijson {
+// A Tape that is stored as is, so it can be queried in place without parsing (e.g. from a mapped
+// file). The layout is a 24 byte header followed by the tape entries and the strings buffer:
+// - "MJT1"
+// - uint32_t 0x01020304 in the byte order of the writer, which has to match the reader's
+// - uint64_t number of entries
+// - uint64_t size of the strings buffer
+// All offsets in the tape are relative, so the blob doesn't depend on where it is loaded.
+std::string encodeTape(const Tape& tape);
+
+// The blob has to be 8-byte aligned (which allocations and mappings are) and stay alive as long as
+// the view. checkEntries walks the whole tape once and makes sure that navigating it can't go out
+// of bounds. That is still much cheaper than parsing, but can be skipped for trusted blobs.
+// Errors have the offset of the offending header field or entry as the cursor.
+Result<TapeView> decodeTape(std::string_view blob, bool checkEntries = true);
+
+// Writes encodeTape(tape) to the file, replacing it if it exists
+std::optional<Error> writeTapeFile(const Tape& tape, const std::string& path);
+
+// Keeps the mapping alive as long as the view
+class MappedTape {
+public:
+    MappedTape(MappedFile file, TapeView view) : file_(std::move(file)), view_(view) { }
+
+    ValueRef root() const { return view_.root(); }
+    ValueRef operator[](std::string_view key) const { return root()[key]; }
+    ValueRef operator[](size_t index) const { return root()[index]; }
+    const TapeView& view() const { return view_; }
+
+private:
+    MappedFile file_;
+    TapeView view_;
+};
+
+// Maps a file written by writeTapeFile. Loading costs the mmap and (with checkEntries) one pass
+// over the entries.
+Result<MappedTape> openTapeFile(const std::string& path, bool checkEntries = true);
+}
@@ -0,0 +1,520 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "minijson.hpp"
+#include "minijson_sax.hpp"
+#include "minijson_scan.hpp"
+#include "minijson_writer.hpp"
+
+// Parsing directly into structs (and writing them) without building a JsonValue in between.
+// Structs are described by specializing minijson::Binding:
+//
+//     struct Point {
+//         double x;
+//         double y;
+//         std::optional<std::string> label;
+//     };
+//
+//     template <>
+//     struct minijson::Binding<Point> {
+//         static constexpr auto fields = std::make_tuple(MINIJSON_FIELD(Point, x),
+//             MINIJSON_FIELD(Point, y), minijson::field("name", &Point::label));
+//     };
+//
+//     const auto point = minijson::parseAs<Point>(R"({"x": 1, "y": 2})");
+//     const auto json = minijson::serialize(*point);
+//
+// Besides bound structs, members can be bool, integers, floating point numbers, std::string,
+// std::optional and std::vector of any of these.
+// Unknown keys are skipped, missing ones leave the member as it is and of duplicate keys only the
+// first one is used (like parse does). Values of the wrong type (including integers that don't
+// fit) are an error. null is only accepted for std::optional, which it resets.
+namespace minijson {
+template <typename Class, typename T>
+struct Field {
+    std::string_view name;
+    T Class::*member;
+};
+
+template <typename Class, typename T>
+constexpr Field<Class, T> field(std::string_view name, T Class::*member)
+{
+    return Field<Class, T> { name, member };
+}
+
+// A field with the same name as the member
+#define MINIJSON_FIELD(Class, member) ::minijson::field(#member, &Class::member)
+
+// Specializations provide `static constexpr auto fields`, a tuple of Fields
+template <typename T>
+struct Binding;
+
+namespace detail {
+    template <typename T, typename = void>
+    struct HasBinding : std::false_type { };
+
+    template <typename T>
+    struct HasBinding<T, std::void_t<decltype(Binding<T>::fields)>> : std::true_type { };
+
+    // FNV-1a. The hashes of the field names are computed at compile time, so dispatching a key
+    // mostly compares integers.
+    constexpr uint64_t hashKey(std::string_view key)
+    {
+        uint64_t hash = 0xcbf2'9ce4'8422'2325;
+        for (const auto c : key) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100'0000'01b3;
+        }
+        return hash;
+    }
+
+    struct BindOps;
+
+    // Where the next value goes. No ops means the value is skipped.
+    struct BindTarget {
+        void* object = nullptr;
+        const BindOps* ops = nullptr;
+    };
+
+    // Type-erased, so the handler can keep targets of different types on its stack. Every
+    // callback returns false if the value doesn't fit the target's type.
+    struct BindOps {
+        ErrorCode expected;
+        bool (*onNull)(void*);
+        bool (*onBool)(void*, bool);
+        bool (*onInt)(void*, int64_t);
+        bool (*onUInt)(void*, uint64_t);
+        bool (*onNumber)(void*, double);
+        bool (*onString)(void*, std::string_view);
+        bool (*onStartArray)(void*);
+        // Appends an element and returns it as the target for the next value
+        BindTarget (*element)(void*);
+        bool (*onStartObject)(void*);
+        // `seen` has a bit for each field that has already been set
+        BindTarget (*member)(void*, std::string_view key, uint64_t& seen);
+    };
+
+    template <typename T, typename = void>
+    struct Binder;
+
+    template <typename T>
+    const BindOps* getBindOps();
+
+    template <typename T>
+    BindTarget makeTarget(T& object)
+    {
+        return BindTarget { &object, getBindOps<T>() };
+    }
+
+    // The defaults reject everything
+    struct BinderBase {
+        static bool onNull(void*) { return false; }
+        static bool onBool(void*, bool) { return false; }
+        static bool onInt(void*, int64_t) { return false; }
+        static bool onUInt(void*, uint64_t) { return false; }
+        static bool onNumber(void*, double) { return false; }
+        static bool onString(void*, std::string_view) { return false; }
+        static bool onStartArray(void*) { return false; }
+        static BindTarget element(void*) { return BindTarget {}; }
+        static bool onStartObject(void*) { return false; }
+        static BindTarget member(void*, std::string_view, uint64_t&) { return BindTarget {}; }
+    };
+
+    template <>
+    struct Binder<bool> : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedBool;
+
+        static bool onBool(void* object, bool value)
+        {
+            *static_cast<bool*>(object) = value;
+            return true;
+        }
+
+        static void write(Writer& writer, bool value) { writer.boolean(value); }
+    };
+
+    template <typename T>
+    struct Binder<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>>
+        : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedInteger;
+        using Limits = std::numeric_limits<T>;
+
+        static bool onInt(void* object, int64_t value)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                if (value < Limits::min() || value > Limits::max()) {
+                    return false;
+                }
+            } else {
+                if (value < 0 || static_cast<uint64_t>(value) > Limits::max()) {
+                    return false;
+                }
+            }
+            *static_cast<T*>(object) = static_cast<T>(value);
+            return true;
+        }
+
+        static bool onUInt(void* object, uint64_t value)
+        {
+            if (value > static_cast<std::make_unsigned_t<T>>(Limits::max())) {
+                return false;
+            }
+            *static_cast<T*>(object) = static_cast<T>(value);
+            return true;
+        }
+
+        // For integers written like 1e3 or 2.0
+        static bool onNumber(void* object, double value)
+        {
+            if (std::trunc(value) != value || value < -0x1p63 || value >= 0x1p64) {
+                return false;
+            }
+            return value < 0 ? onInt(object, static_cast<int64_t>(value))
+                             : onUInt(object, static_cast<uint64_t>(value));
+        }
+
+        static void write(Writer& writer, T value)
+        {
+            if constexpr (std::is_signed_v<T>) {
+                writer.number(static_cast<int64_t>(value));
+            } else {
+                writer.number(static_cast<uint64_t>(value));
+            }
+        }
+    };
+
+    template <typename T>
+    struct Binder<T, std::enable_if_t<std::is_floating_point_v<T>>> : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedNumber;
+
+        static bool onInt(void* object, int64_t value) { return onNumber(object, value); }
+        static bool onUInt(void* object, uint64_t value) { return onNumber(object, value); }
+        static bool onNumber(void* object, double value)
+        {
+            *static_cast<T*>(object) = static_cast<T>(value);
+            return true;
+        }
+
+        static void write(Writer& writer, T value) { writer.number(static_cast<double>(value)); }
+    };
+
+    template <>
+    struct Binder<std::string> : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedString;
+
+        static bool onString(void* object, std::string_view value)
+        {
+            static_cast<std::string*>(object)->assign(value);
+            return true;
+        }
+
+        static void write(Writer& writer, const std::string& value) { writer.string(value); }
+    };
+
+    template <typename T>
+    struct Binder<std::optional<T>> : BinderBase {
+        static constexpr ErrorCode expected = Binder<T>::expected;
+
+        // Anything but null goes into the contained value
+        static T& get(void* object)
+        {
+            auto& optional = *static_cast<std::optional<T>*>(object);
+            if (!optional) {
+                optional.emplace();
+            }
+            return *optional;
+        }
+
+        static bool onNull(void* object)
+        {
+            static_cast<std::optional<T>*>(object)->reset();
+            return true;
+        }
+        static bool onBool(void* o, bool v) { return Binder<T>::onBool(&get(o), v); }
+        static bool onInt(void* o, int64_t v) { return Binder<T>::onInt(&get(o), v); }
+        static bool onUInt(void* o, uint64_t v) { return Binder<T>::onUInt(&get(o), v); }
+        static bool onNumber(void* o, double v) { return Binder<T>::onNumber(&get(o), v); }
+        static bool onString(void* o, std::string_view v)
+        {
+            return Binder<T>::onString(&get(o), v);
+        }
+        static bool onStartArray(void* o) { return Binder<T>::onStartArray(&get(o)); }
+        static BindTarget element(void* o) { return Binder<T>::element(&get(o)); }
+        static bool onStartObject(void* o) { return Binder<T>::onStartObject(&get(o)); }
+        static BindTarget member(void* o, std::string_view key, uint64_t& seen)
+        {
+            return Binder<T>::member(&get(o), key, seen);
+        }
+
+        static void write(Writer& writer, const std::optional<T>& value)
+        {
+            if (value) {
+                Binder<T>::write(writer, *value);
+            } else {
+                writer.null();
+            }
+        }
+    };
+
+    template <typename T>
+    struct Binder<std::vector<T>> : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedArray;
+
+        static bool onStartArray(void* object)
+        {
+            static_cast<std::vector<T>*>(object)->clear();
+            return true;
+        }
+
+        static BindTarget element(void* object)
+        {
+            return makeTarget(static_cast<std::vector<T>*>(object)->emplace_back());
+        }
+
+        static void write(Writer& writer, const std::vector<T>& value)
+        {
+            writer.startArray();
+            for (const auto& element : value) {
+                Binder<T>::write(writer, element);
+            }
+            writer.endArray();
+        }
+    };
+
+    template <typename T>
+    struct Binder<T, std::enable_if_t<HasBinding<T>::value>> : BinderBase {
+        static constexpr ErrorCode expected = ErrorCode::ExpectedObject;
+        static constexpr auto& fields = Binding<T>::fields;
+        static constexpr auto numFields = std::tuple_size_v<std::decay_t<decltype(fields)>>;
+        static_assert(numFields <= 64, "Only up to 64 fields are supported");
+
+        template <size_t... I>
+        static constexpr std::array<uint64_t, numFields> hashNames(std::index_sequence<I...>)
+        {
+            return { hashKey(std::get<I>(fields).name)... };
+        }
+        static constexpr auto hashes = hashNames(std::make_index_sequence<numFields>());
+
+        static bool onStartObject(void*) { return true; }
+
+        template <size_t... I>
+        static BindTarget findMember(
+            T& object, std::string_view key, uint64_t& seen, std::index_sequence<I...>)
+        {
+            const auto hash = hashKey(key);
+            BindTarget target;
+            // Stops at the first match
+            [[maybe_unused]] const auto found
+                = ((hashes[I] == hash && std::get<I>(fields).name == key
+                       && (seen & (uint64_t(1) << I)) == 0
+                       && (seen |= uint64_t(1) << I,
+                           target = makeTarget(object.*(std::get<I>(fields).member)), true))
+                    || ...);
+            return target;
+        }
+
+        static BindTarget member(void* object, std::string_view key, uint64_t& seen)
+        {
+            return findMember(*static_cast<T*>(object), key, seen,
+                std::make_index_sequence<numFields>());
+        }
+
+        static void write(Writer& writer, const T& value)
+        {
+            writer.startObject();
+            std::apply(
+                [&](const auto&... field) {
+                    ((writer.key(field.name), writeMember(writer, value.*(field.member))), ...);
+                },
+                fields);
+            writer.endObject();
+        }
+
+        template <typename M>
+        static void writeMember(Writer& writer, const M& member)
+        {
+            Binder<M>::write(writer, member);
+        }
+    };
+
+    template <typename T>
+    const BindOps* getBindOps()
+    {
+        using B = Binder<T>;
+        static constexpr BindOps ops { B::expected, B::onNull, B::onBool, B::onInt, B::onUInt,
+            B::onNumber, B::onString, B::onStartArray, B::element, B::onStartObject, B::member };
+        return &ops;
+    }
+
+    class BindHandler {
+    public:
+        explicit BindHandler(BindTarget root) : next_(root) { }
+
+        bool onNull() { return scalar([](BindTarget t) { return t.ops->onNull(t.object); }); }
+        bool onBool(bool v)
+        {
+            return scalar([&](BindTarget t) { return t.ops->onBool(t.object, v); });
+        }
+        bool onInt(int64_t v)
+        {
+            return scalar([&](BindTarget t) { return t.ops->onInt(t.object, v); });
+        }
+        bool onUInt(uint64_t v)
+        {
+            return scalar([&](BindTarget t) { return t.ops->onUInt(t.object, v); });
+        }
+        bool onNumber(double v)
+        {
+            return scalar([&](BindTarget t) { return t.ops->onNumber(t.object, v); });
+        }
+        bool onString(std::string_view v)
+        {
+            return scalar([&](BindTarget t) { return t.ops->onString(t.object, v); });
+        }
+
+        bool onKey(std::string_view key)
+        {
+            if (skipDepth_ == 0) {
+                auto& frame = stack_.back();
+                next_ = frame.target.ops->member(frame.target.object, key, frame.seen);
+            }
+            return true;
+        }
+
+        bool onStartArray() { return startContainer(false); }
+        bool onEndArray(size_t) { return endContainer(); }
+        bool onStartObject() { return startContainer(true); }
+        bool onEndObject(size_t) { return endContainer(); }
+
+        // Set if a value didn't fit its target
+        ErrorCode error() const { return error_; }
+
+    private:
+        struct Frame {
+            BindTarget target;
+            bool isObject;
+            uint64_t seen;
+        };
+
+        BindTarget nextTarget()
+        {
+            if (!stack_.empty() && !stack_.back().isObject) {
+                const auto& array = stack_.back().target;
+                return array.ops->element(array.object);
+            }
+            return next_;
+        }
+
+        bool mismatch(BindTarget target)
+        {
+            error_ = target.ops->expected;
+            return false;
+        }
+
+        template <typename Func>
+        bool scalar(Func&& func)
+        {
+            if (skipDepth_ > 0) {
+                return true;
+            }
+            const auto target = nextTarget();
+            return !target.ops || func(target) || mismatch(target);
+        }
+
+        bool startContainer(bool isObject)
+        {
+            if (skipDepth_ > 0) {
+                skipDepth_++;
+                return true;
+            }
+            const auto target = nextTarget();
+            if (!target.ops) {
+                skipDepth_ = 1;
+                return true;
+            }
+            const auto ok = isObject ? target.ops->onStartObject(target.object)
+                                     : target.ops->onStartArray(target.object);
+            if (!ok) {
+                return mismatch(target);
+            }
+            stack_.push_back(Frame { target, isObject, 0 });
+            return true;
+        }
+
+        bool endContainer()
+        {
+            if (skipDepth_ > 0) {
+                skipDepth_--;
+            } else {
+                stack_.pop_back();
+            }
+            return true;
+        }
+
+        std::vector<Frame> stack_;
+        // For the value after a key (or the root)
+        BindTarget next_;
+        // Depth inside of a value that is skipped
+        size_t skipDepth_ = 0;
+        ErrorCode error_ = ErrorCode::None;
+    };
+}
+
+// Parses into an existing value, so members that are not in the source keep their values.
+// Of the options only maxDepth applies.
+template <typename T>
+std::optional<Error> parseAs(std::string_view source, T& value, const ParseOptions& options = {})
+{
+    detail::BindHandler handler(detail::makeTarget(value));
+    const auto res = parseSax(source, handler, options);
+    if (!res) {
+        if (handler.error() != ErrorCode::None) {
+            return Error { handler.error(), res.error().cursor };
+        }
+        return res.error();
+    }
+    // Like parse, the source has to be a single value
+    const auto end = detail::findNonWhitespace(source.data(), source.size(), *res);
+    if (end < source.size()) {
+        return Error { ErrorCode::TrailingCharacters, end };
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+Result<T> parseAs(std::string_view source, const ParseOptions& options = {})
+{
+    T value {};
+    if (auto error = parseAs(source, value, options)) {
+        return std::move(*error);
+    }
+    return value;
+}
+
+template <typename T>
+void serialize(Writer& writer, const T& value)
+{
+    detail::Binder<T>::write(writer, value);
+}
+
+template <typename T>
+std::string serialize(const T& value, const WriteOptions& options = {})
+{
+    std::string str;
+    StringSink sink(str);
+    Writer writer(sink, options);
+    serialize(writer, value);
+    writer.flush();
+    return str;
+}
+}
@@ -0,0 +1,346 @@
+#include "minijson_document.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <utility>
+
+#include "minijson_index.hpp"
+#include "minijson_parallel.hpp"
+#include "minijson_sax.hpp"
+
+namespace {
+using namespace minijson;
+
+// A DOM takes about ten times the size of the source (including everything that is left behind
+// when containers grow). Pages of the arena that are never touched don't cost anything, so it's
+// better to err on the large side than to add chunks. But a single reservation of many GB fails
+// if overcommit is limited, so beyond the cap the arena grows in (doubling) chunks instead.
+constexpr size_t bytesPerSourceByte = 12;
+constexpr size_t maxReservation = size_t(256) << 20;
+
+size_t getReservation(size_t sourceSize)
+{
+    return sourceSize > maxReservation / bytesPerSourceByte ? maxReservation
+                                                             : sourceSize * bytesPerSourceByte;
+}
+
+// Finds the commas between the elements of the array between the brackets at `open` and `close`
+// and returns them surrounded by the brackets. The source is split into chunks that are scanned in
+// parallel: first for the quotes, which tells every chunk whether it starts in a string, then for
+// the commas and the nesting depth.
+// Invalid input can be split wrongly, but then some element will not parse.
+bool findSeparators(std::string_view source, size_t open, size_t close, size_t numThreads,
+    std::vector<size_t>& separators)
+{
+    constexpr size_t minChunkSize = 64 * 1024;
+    const auto interior = close - open - 1;
+    const auto numChunks = std::max<size_t>(std::min(numThreads, interior / minChunkSize), 1);
+    std::vector<size_t> bounds(numChunks + 1);
+    for (size_t i = 0; i <= numChunks; ++i) {
+        bounds[i] = open + 1 + interior * i / numChunks;
+    }
+
+    std::vector<char> inString(numChunks + 1, false);
+    detail::parallelFor(numChunks, 1, numThreads, [&](size_t, size_t i, size_t) {
+        inString[i + 1] = detail::hasOddQuotes(source, bounds[i], bounds[i + 1]);
+    });
+    for (size_t i = 1; i <= numChunks; ++i) {
+        inString[i] = inString[i] != inString[i - 1];
+    }
+    if (inString[numChunks]) {
+        return false;
+    }
+
+    std::vector<detail::ArrayOutline> outlines(numChunks);
+    detail::parallelFor(numChunks, 1, numThreads, [&](size_t, size_t i, size_t) {
+        outlines[i] = detail::scanOutline(source, bounds[i], bounds[i + 1], inString[i]);
+    });
+
+    separators.push_back(open);
+    ptrdiff_t depth = 1;
+    for (const auto& outline : outlines) {
+        // The array would end before `close`
+        if (depth + outline.minDepth < 1) {
+            return false;
+        }
+        if (depth + outline.minDepth == 1) {
+            separators.insert(separators.end(), outline.commas.begin(), outline.commas.end());
+        }
+        depth += outline.depth;
+    }
+    separators.push_back(close);
+    return true;
+}
+
+// The element between two separators
+std::string_view getElement(std::string_view source, size_t before, size_t after)
+{
+    const auto begin = detail::findNonWhitespace(source.data(), after, before + 1);
+    auto end = after;
+    while (end > begin && detail::isWhitespace(source[end - 1])) {
+        end--;
+    }
+    return source.substr(begin, end - begin);
+}
+}
+
+namespace minijson {
+Document::Document(size_t capacity)
+    : arena_(std::make_unique<Arena>(capacity))
+{
+    reset();
+}
+
+void Document::reset()
+{
+    arena_->reset();
+    root_ = new (arena_->allocate(sizeof(JsonValue), alignof(JsonValue))) JsonValue();
+}
+
+bool Document::parse(std::string_view source, const ParseOptions& options)
+{
+    arena_->reset();
+    arena_->reserve(getReservation(source.size()));
+    root_ = new (arena_->allocate(sizeof(JsonValue), alignof(JsonValue))) JsonValue();
+    auto res = minijson::parse(source, arena_.get(), options);
+    if (!res) {
+        error_ = res.error();
+        return false;
+    }
+    *root_ = std::move(*res);
+    return true;
+}
+
+bool Document::reparse(std::string_view source, const ParseOptions& options)
+{
+    if (auto error = parseInto(*root_, source, arena_.get(), options)) {
+        error_ = *error;
+        return false;
+    }
+    return true;
+}
+
+ParallelDocument::ParallelDocument(const ParallelOptions& options)
+    : options_(options)
+{
+    const auto numThreads = detail::getNumThreads(options.numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        arenas_.push_back(std::make_unique<Arena>());
+    }
+    reset();
+}
+
+void ParallelDocument::reset()
+{
+    for (auto& arena : arenas_) {
+        arena->reset();
+    }
+    root_ = new (arenas_[0]->allocate(sizeof(JsonValue), alignof(JsonValue))) JsonValue();
+}
+
+bool ParallelDocument::parse(std::string_view source)
+{
+    reset();
+    const auto open = detail::findNonWhitespace(source.data(), source.size(), 0);
+    auto close = source.size();
+    while (close > open && detail::isWhitespace(source[close - 1])) {
+        close--;
+    }
+    // Interners that are not frozen can't be shared between threads
+    const auto interner = options_.parse.keyInterner;
+    const auto parallel = arenas_.size() > 1 && (!interner || interner->frozen());
+    // Anything after the array would be ignored, but would also make it hard to find its end.
+    // The elements are one level deeper than the root.
+    if (parallel && close > open + 1 && source[open] == '[' && source[close - 1] == ']'
+        && options_.parse.maxDepth > 0 && parseArray(source, open, close - 1)) {
+        return true;
+    }
+    reset();
+    return parseSerial(source);
+}
+
+bool ParallelDocument::parseArray(std::string_view source, size_t open, size_t close)
+{
+    std::vector<size_t> separators;
+    if (!findSeparators(source, open, close, arenas_.size(), separators)) {
+        return false;
+    }
+    auto numElements = separators.size() - 1;
+    if (numElements == 1 && getElement(source, open, close).empty()) {
+        numElements = 0;
+    }
+
+    // Reserving on the calling thread, so the first arena can hold the elements too
+    const auto perWorker = getReservation(source.size()) / arenas_.size();
+    for (auto& arena : arenas_) {
+        arena->reserve(perWorker);
+    }
+    JsonValue::Array elements(arenas_[0].get());
+    elements.resize(numElements);
+
+    auto elementOptions = options_.parse;
+    elementOptions.maxDepth--;
+    std::atomic<bool> failed { false };
+    detail::parallelFor(elements.size(), options_.batchSize, arenas_.size(),
+        [&](size_t worker, size_t begin, size_t end) {
+            for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+                const auto element = getElement(source, separators[i], separators[i + 1]);
+                DomBuilder builder(element, arenas_[worker].get(), elementOptions);
+                const auto res = detail::runSax(element, builder, elementOptions, nullptr);
+                // The whole element has to be a single value (and not e.g. "1 2")
+                if (!res || *res != element.size()) {
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                elements[i] = std::move(builder.root());
+            }
+        });
+    if (failed) {
+        return false;
+    }
+    *root_ = JsonValue(std::move(elements));
+    return true;
+}
+
+bool ParallelDocument::parseSerial(std::string_view source)
+{
+    arenas_[0]->reserve(getReservation(source.size()));
+    auto res = minijson::parse(source, arenas_[0].get(), options_.parse);
+    if (!res) {
+        error_ = res.error();
+        return false;
+    }
+    *root_ = std::move(*res);
+    return true;
+}
+
+DocumentSequence::DocumentSequence(
+    std::string_view source, const SequenceOptions& options, Arena* arena)
+    : source_(source)
+    , options_(options)
+{
+    // Interners that are not frozen can't be shared between threads
+    const auto interner = options_.parse.keyInterner;
+    options_.prefetch = options_.prefetch && (!interner || interner->frozen());
+    if (!arena || options_.prefetch) {
+        ownArena_ = std::make_unique<Arena>();
+        arena = ownArena_.get();
+    }
+    slots_[0].arena = arena;
+    slots_[0].checkpoint = arena->checkpoint();
+    if (options_.prefetch) {
+        prefetchArena_ = std::make_unique<Arena>();
+        slots_[1].arena = prefetchArena_.get();
+        slots_[1].checkpoint = prefetchArena_->checkpoint();
+    }
+}
+
+DocumentSequence::~DocumentSequence()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool DocumentSequence::next()
+{
+    if (finished_) {
+        return false;
+    }
+    Slot* slot = &slots_[0];
+    if (!options_.prefetch) {
+        parseSlot(*slot, nextOffset_);
+    } else {
+        // Only the first document isn't prefetched
+        if (!current_) {
+            requestPrefetch(*slot, nextOffset_);
+        }
+        slot = &waitForPrefetch();
+    }
+
+    if (!slot->root) {
+        finished_ = true;
+        current_ = nullptr;
+        error_ = slot->error;
+        return false;
+    }
+    current_ = slot;
+    nextOffset_ = slot->end;
+    if (options_.prefetch) {
+        requestPrefetch(slot == &slots_[0] ? slots_[1] : slots_[0], nextOffset_);
+    }
+    return true;
+}
+
+void DocumentSequence::parseSlot(Slot& slot, size_t offset)
+{
+    // The value's destructor is never run (see Document)
+    slot.arena->rewind(slot.checkpoint);
+    slot.root = nullptr;
+    slot.offset = detail::findNonWhitespace(source_.data(), source_.size(), offset);
+    slot.end = slot.offset;
+    slot.error = Error {};
+    if (slot.offset == source_.size()) {
+        return;
+    }
+
+    const auto source = source_.substr(slot.offset);
+    DomBuilder builder(source, slot.arena, options_.parse);
+    const auto res = detail::runSax(source, builder, options_.parse, nullptr);
+    if (!res) {
+        slot.error = Error { res.error().code, slot.offset + res.error().cursor };
+        return;
+    }
+    slot.end = slot.offset + *res;
+    slot.root = new (slot.arena->allocate(sizeof(JsonValue), alignof(JsonValue)))
+        JsonValue(std::move(builder.root()));
+}
+
+void DocumentSequence::requestPrefetch(Slot& slot, size_t offset)
+{
+    if (!worker_.joinable()) {
+        worker_ = std::thread([this] { work(); });
+    }
+    {
+        std::lock_guard lock(mutex_);
+        job_ = &slot;
+        jobOffset_ = offset;
+        jobDone_ = false;
+    }
+    cv_.notify_all();
+}
+
+DocumentSequence::Slot& DocumentSequence::waitForPrefetch()
+{
+    std::unique_lock lock(mutex_);
+    cv_.wait(lock, [this] { return jobDone_; });
+    return *std::exchange(job_, nullptr);
+}
+
+void DocumentSequence::work()
+{
+    while (true) {
+        std::unique_lock lock(mutex_);
+        cv_.wait(lock, [this] { return stop_ || (job_ && !jobDone_); });
+        if (stop_) {
+            return;
+        }
+        const auto slot = job_;
+        const auto offset = jobOffset_;
+        lock.unlock();
+
+        parseSlot(*slot, offset);
+
+        lock.lock();
+        jobDone_ = true;
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+}
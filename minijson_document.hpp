@@ -0,0 +1,210 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "minijson.hpp"
+#include "minijson_arena.hpp"
+
+namespace minijson {
+// Owns a parsed value together with the arena it is allocated from. The value's destructor is
+// never run: the arena is freed as a whole, which doesn't depend on the size of the document.
+class Document {
+public:
+    // capacity is the initial size of the arena. If it is 0, it is derived from the first input.
+    explicit Document(size_t capacity = 0);
+
+    // Replaces the current value. The arena is reset first, so any previous value and every
+    // reference into it are invalidated, even if parsing fails.
+    bool parse(std::string_view source, const ParseOptions& options = {});
+    // Overwrites the current value in place (see parseInto), so the arena only grows where the
+    // new document needs more than the old one had. Memory that is dropped is not reused until the
+    // next parse or reset, so documents that keep changing their shape should use parse.
+    bool reparse(std::string_view source, const ParseOptions& options = {});
+    const Error& error() const { return error_; }
+
+    // Invalid if there is no document
+    const JsonValue& root() const { return *root_; }
+    JsonValue& root() { return *root_; }
+
+    // Drops the value, but keeps the memory for the next parse
+    void reset();
+
+    // Values that are added to the document have to be allocated from here
+    std::pmr::memory_resource* memoryResource() const { return arena_.get(); }
+
+private:
+    // On the heap, so the values that refer to it survive moving the Document
+    std::unique_ptr<Arena> arena_;
+    JsonValue* root_;
+    Error error_;
+};
+
+struct ParallelOptions {
+    ParseOptions parse;
+    // 0 means std::thread::hardware_concurrency()
+    size_t numThreads = 0;
+    // Number of array elements a worker claims at once
+    size_t batchSize = 256;
+};
+
+// Like Document, but if the root is an array, its elements are parsed in parallel. The element
+// boundaries are found with a parallel scan that only looks at quotes, brackets and commas first,
+// then every worker parses batches of elements into an arena of its own. Roots that are not arrays
+// (and anything with a single thread or with a KeyInterner that is not frozen) are parsed on the
+// calling thread.
+// If anything goes wrong, the whole source is parsed again on the calling thread, so the result
+// (and the error) is exactly what Document::parse would produce.
+class ParallelDocument {
+public:
+    explicit ParallelDocument(const ParallelOptions& options = {});
+
+    // Same as Document::parse
+    bool parse(std::string_view source);
+    const Error& error() const { return error_; }
+
+    // Invalid if there is no document
+    const JsonValue& root() const { return *root_; }
+    JsonValue& root() { return *root_; }
+
+    void reset();
+
+    // Values that are added to the document have to be allocated from here
+    std::pmr::memory_resource* memoryResource() const { return arenas_[0].get(); }
+
+private:
+    // `open` and `close` are the positions of the brackets
+    bool parseArray(std::string_view source, size_t open, size_t close);
+    bool parseSerial(std::string_view source);
+
+    ParallelOptions options_;
+    // One per worker. The first one also holds the root and its elements.
+    std::vector<std::unique_ptr<Arena>> arenas_;
+    JsonValue* root_;
+    Error error_;
+};
+
+struct SequenceOptions {
+    ParseOptions parse;
+    // Parses the next document on a background thread while the current one is being used. This
+    // needs two arenas, which are both owned by the sequence, so an arena that is passed to the
+    // sequence is not used. Ignored with a KeyInterner that is not frozen.
+    bool prefetch = false;
+};
+
+// Parses a source that holds any number of concatenated values (e.g. `{...}{...}[...]`), which
+// may be separated by whitespace, one after another. Only one document is alive at a time: every
+// call to next() rewinds the arena to a checkpoint, which frees the previous document (and
+// anything else that was allocated from memoryResource() since), but keeps its memory.
+class DocumentSequence {
+public:
+    class Iterator;
+
+    // If arena is nullptr (or with prefetch, because the worker would use it concurrently with the
+    // caller), the sequence uses an arena of its own. Otherwise it may already hold other values,
+    // which are left alone, and it has to outlive the sequence.
+    explicit DocumentSequence(
+        std::string_view source, const SequenceOptions& options = {}, Arena* arena = nullptr);
+    ~DocumentSequence();
+
+    DocumentSequence(const DocumentSequence&) = delete;
+    DocumentSequence& operator=(const DocumentSequence&) = delete;
+
+    // Advances to the next document. Returns false at the end of the source and if the document
+    // could not be parsed (see error()). Nothing is parsed after the first error.
+    bool next();
+    // ErrorCode::None if the sequence just ended. Error cursors are offsets into the whole source.
+    const Error& error() const { return error_; }
+
+    // Invalid if there is no current document
+    const JsonValue& root() const { return current_ ? *current_->root : invalid_; }
+    JsonValue& root() { return current_ ? *current_->root : invalid_; }
+    // The range of the current document in the source
+    size_t offset() const { return current_ ? current_->offset : 0; }
+    size_t endOffset() const { return current_ ? current_->end : 0; }
+
+    // Values that are added to the current document have to be allocated from here
+    std::pmr::memory_resource* memoryResource() const
+    {
+        return current_ ? current_->arena : slots_[0].arena;
+    }
+
+    // Starts with the next document, so a sequence can only be iterated over once
+    Iterator begin();
+    Iterator end();
+
+private:
+    struct Slot {
+        Arena* arena = nullptr;
+        Arena::Checkpoint checkpoint;
+        // nullptr if there is no value (at the end of the source or after errors)
+        JsonValue* root = nullptr;
+        size_t offset = 0;
+        size_t end = 0;
+        Error error;
+    };
+
+    void parseSlot(Slot& slot, size_t offset);
+    void requestPrefetch(Slot& slot, size_t offset);
+    Slot& waitForPrefetch();
+    void work();
+
+    std::string_view source_;
+    SequenceOptions options_;
+    std::unique_ptr<Arena> ownArena_;
+    std::unique_ptr<Arena> prefetchArena_;
+    // slots_[1] is only used for prefetching
+    Slot slots_[2];
+    Slot* current_ = nullptr;
+    size_t nextOffset_ = 0;
+    bool finished_ = false;
+    Error error_;
+    JsonValue invalid_;
+
+    // Protect the job. The worker only touches slots that are handed to it and never the current
+    // one.
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    Slot* job_ = nullptr;
+    size_t jobOffset_ = 0;
+    bool jobDone_ = false;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+class DocumentSequence::Iterator {
+public:
+    explicit Iterator(DocumentSequence* sequence) : sequence_(sequence) { }
+
+    JsonValue& operator*() const { return sequence_->root(); }
+    JsonValue* operator->() const { return &sequence_->root(); }
+    Iterator& operator++()
+    {
+        if (!sequence_->next()) {
+            sequence_ = nullptr;
+        }
+        return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return sequence_ == other.sequence_; }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+private:
+    // nullptr at the end
+    DocumentSequence* sequence_;
+};
+
+inline DocumentSequence::Iterator DocumentSequence::begin()
+{
+    return Iterator(next() ? this : nullptr);
+}
+
+inline DocumentSequence::Iterator DocumentSequence::end()
+{
+    return Iterator(nullptr);
+}
+}
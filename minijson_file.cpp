@@ -0,0 +1,90 @@
+#include "minijson_file.hpp"
+
+#include <cerrno>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+minijson::Error makeError(minijson::ErrorCode code)
+{
+    return minijson::Error { code, 0, errno };
+}
+}
+
+namespace minijson {
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0))
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+Result<MappedFile> MappedFile::open(const std::string& path)
+{
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return makeError(ErrorCode::CouldNotOpenFile);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        const auto error = makeError(ErrorCode::CouldNotGetFileSize);
+        ::close(fd);
+        return error;
+    }
+    const auto size = static_cast<size_t>(st.st_size);
+    // mmap fails for empty files
+    if (size == 0) {
+        ::close(fd);
+        return MappedFile();
+    }
+
+    const auto addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr == MAP_FAILED) {
+        const auto error = makeError(ErrorCode::CouldNotMapFile);
+        ::close(fd);
+        return error;
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+
+    // These are only hints, so errors are ignored
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    ::madvise(addr, size, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+    // Only has an effect for file mappings if the kernel supports THP for the page cache
+    ::madvise(addr, size, MADV_HUGEPAGE);
+#endif
+    return MappedFile(static_cast<const char*>(addr), size);
+}
+
+Result<FileDocument> parseFile(
+    const std::string& path, const ParseOptions& options, std::pmr::memory_resource* memRes)
+{
+    auto file = MappedFile::open(path);
+    if (!file) {
+        return file.error();
+    }
+    auto root = parse(file->view(), options, memRes);
+    if (!root) {
+        return root.error();
+    }
+    return FileDocument(std::move(*file), std::move(*root));
+}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+#include "minijson.hpp"
+
+namespace minijson {
+// A read-only memory mapping of a whole file (POSIX)
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Hints the kernel that the file will be read sequentially soon and asks for transparent huge
+    // pages where that is supported. Errors have cursor 0.
+    static Result<MappedFile> open(const std::string& path);
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    MappedFile(const char* data, size_t size) : data_(data), size_(size) { }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Keeps the mapping alive as long as the value, so zeroCopyStrings can be used safely
+class FileDocument {
+public:
+    FileDocument(MappedFile file, JsonValue root) : file_(std::move(file)), root_(std::move(root))
+    {
+    }
+
+    const JsonValue& root() const { return root_; }
+    JsonValue& root() { return root_; }
+    std::string_view source() const { return file_.view(); }
+
+private:
+    // Declared first, so it is destroyed last
+    MappedFile file_;
+    JsonValue root_;
+};
+
+// Parses directly from a mapping of the file. Error cursors are offsets into the file.
+Result<FileDocument> parseFile(const std::string& path, const ParseOptions& options = {},
+    std::pmr::memory_resource* memRes = std::pmr::get_default_resource());
+}
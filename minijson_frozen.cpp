@@ -0,0 +1,19 @@
+#include "minijson_frozen.hpp"
+
+namespace minijson {
+Result<FrozenDocument::Ptr> FrozenDocument::parse(
+    std::string_view source, const ParseOptions& options)
+{
+    Document document;
+    if (!document.parse(source, options)) {
+        return document.error();
+    }
+    return freeze(std::move(document));
+}
+
+FrozenDocument::Ptr FrozenDocument::freeze(Document document)
+{
+    // Not make_shared, which would put the reference count right next to the document
+    return Ptr(new FrozenDocument(std::move(document)));
+}
+}
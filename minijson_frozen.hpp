@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "minijson.hpp"
+#include "minijson_document.hpp"
+
+namespace minijson {
+namespace detail {
+constexpr size_t cacheLineSize = 64;
+}
+
+// A document that can't be changed anymore, so any number of threads can read it concurrently
+// (everything that is const on JsonValue only reads). Object indices are built while parsing, not
+// on the first lookup. The values live in a single arena, which is reserved up front for all but
+// very large documents, and the document is aligned to a cache line of its own, so the reference
+// count of its handle doesn't share a line with anything the readers need.
+class alignas(detail::cacheLineSize) FrozenDocument {
+public:
+    using Ptr = std::shared_ptr<const FrozenDocument>;
+
+    static Result<Ptr> parse(std::string_view source, const ParseOptions& options = {});
+    // Takes over a document that was parsed (and maybe modified) before
+    static Ptr freeze(Document document);
+
+    const JsonValue& root() const { return document_.root(); }
+
+    // Convenience forwarding to root()
+    const JsonValue& operator[](std::string_view key) const { return root()[key]; }
+    const JsonValue& operator[](size_t index) const { return root()[index]; }
+
+private:
+    explicit FrozenDocument(Document document) : document_(std::move(document)) { }
+
+    Document document_;
+};
+
+// Holds the current version of a FrozenDocument, which can be replaced at any time (e.g. when a
+// configuration is reloaded) without stopping the readers. A replaced document is freed when the
+// last handle to it is dropped, so readers that are still using it are not affected.
+// Readers should use (one per thread) Reader, which only does an atomic load of the version as
+// long as the document doesn't change and never touches the reference count then.
+class AtomicDocument {
+public:
+    class Reader;
+
+    explicit AtomicDocument(FrozenDocument::Ptr document = nullptr)
+        : document_(std::move(document))
+    {
+    }
+
+    AtomicDocument(const AtomicDocument&) = delete;
+    AtomicDocument& operator=(const AtomicDocument&) = delete;
+
+    // nullptr if there is no document
+    FrozenDocument::Ptr load() const { return std::atomic_load(&document_); }
+    void store(FrozenDocument::Ptr document) { exchange(std::move(document)); }
+    FrozenDocument::Ptr exchange(FrozenDocument::Ptr document)
+    {
+        auto old = std::atomic_exchange(&document_, std::move(document));
+        version_.fetch_add(1, std::memory_order_release);
+        return old;
+    }
+
+    // Incremented by every store
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    // Read by every Reader all the time, but only written on stores
+    alignas(detail::cacheLineSize) std::atomic<uint64_t> version_ { 0 };
+    alignas(detail::cacheLineSize) FrozenDocument::Ptr document_;
+};
+
+// A cached handle to the current document. Not thread-safe itself.
+class alignas(detail::cacheLineSize) AtomicDocument::Reader {
+public:
+    explicit Reader(const AtomicDocument& source) : source_(&source) { refresh(); }
+
+    // Switches to the latest document if it was replaced since the last call. The handle stays
+    // valid until the next call, so one document is used for the whole of e.g. a request.
+    const FrozenDocument::Ptr& get()
+    {
+        if (source_->version() != version_) {
+            refresh();
+        }
+        return document_;
+    }
+
+private:
+    void refresh()
+    {
+        // If there is a store in between, the document is newer than the version, which only
+        // means that it's loaded again on the next call
+        version_ = source_->version();
+        document_ = source_->load();
+    }
+
+    const AtomicDocument* source_;
+    uint64_t version_ = 0;
+    FrozenDocument::Ptr document_;
+};
+}
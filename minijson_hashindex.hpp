@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// SSE2 and NEON are part of the baseline of x86-64 and AArch64, so no runtime dispatch is needed
+#if defined(__SSE2__) || defined(_M_X64)
+#define MINIJSON_HASH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MINIJSON_HASH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace minijson::detail {
+// Open addressing hash index in the style of SwissTable: every slot has a control byte, which is
+// either empty (0x80) or holds the top 7 bits of the hash of the key in the slot. A lookup
+// compares a whole group of control bytes at once and only looks at the keys (which usually
+// means a cache miss each) whose control byte matches, which is ~1/128 of the wrong ones.
+// The slots hold indices into the members of an object. There are no deletions; the index is
+// rebuilt instead.
+class HashIndex {
+public:
+    explicit HashIndex(std::pmr::memory_resource* memRes) : control_(memRes), slots_(memRes) { }
+
+    bool empty() const { return slots_.empty(); }
+
+    void clear()
+    {
+        control_.clear();
+        slots_.clear();
+    }
+
+    // Drops all entries and makes room for at least `count`
+    void reset(size_t count)
+    {
+        // The load factor starts below 1/2, so there is room to grow before the next reset
+        size_t capacity = minCapacity;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+        control_.assign(capacity, emptyControl);
+        slots_.assign(capacity, 0);
+    }
+
+    // Whether `count` entries would exceed the maximum load factor of 7/8, so the index has to be
+    // reset before adding more
+    bool isFull(size_t count) const { return count * 8 > slots_.size() * 7; }
+
+    // Must not be full (see isFull)
+    void insert(size_t hash, uint32_t value)
+    {
+        const auto mask = numGroups() - 1;
+        auto group = hash & mask;
+        for (size_t step = 1;; ++step) {
+            const auto empty = matchEmpty(group);
+            if (empty) {
+                const auto slot = group * groupSize + firstIndex(empty);
+                control_[slot] = getControl(hash);
+                slots_[slot] = value;
+                return;
+            }
+            // Triangular numbers visit every group of a power of two
+            group = (group + step) & mask;
+        }
+    }
+
+    // Returns the first value for which matches(value) returns true or `notFound`
+    template <typename Matches>
+    size_t find(size_t hash, Matches&& matches, size_t notFound) const
+    {
+        const auto control = getControl(hash);
+        const auto mask = numGroups() - 1;
+        auto group = hash & mask;
+        for (size_t step = 1;; ++step) {
+            for (auto candidates = match(group, control); candidates;
+                 candidates = clearFirst(candidates)) {
+                const auto value = slots_[group * groupSize + firstIndex(candidates)];
+                if (matches(value)) {
+                    return value;
+                }
+            }
+            // The key would have been inserted into the first empty slot
+            if (matchEmpty(group)) {
+                return notFound;
+            }
+            group = (group + step) & mask;
+        }
+    }
+
+private:
+    static constexpr uint8_t emptyControl = 0x80;
+
+    static uint8_t getControl(size_t hash)
+    {
+        return static_cast<uint8_t>(hash >> (sizeof(size_t) * 8 - 7));
+    }
+
+    // The masks have one bit (or one nibble with NEON) per control byte that matches
+#if defined(MINIJSON_HASH_SSE2)
+    static constexpr size_t groupSize = 16;
+    static constexpr size_t bitsPerSlot = 1;
+
+    uint64_t match(size_t group, uint8_t control) const
+    {
+        const auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(control_.data() + group * groupSize));
+        const auto eq = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(control)));
+        return static_cast<uint32_t>(_mm_movemask_epi8(eq));
+    }
+
+    uint64_t matchEmpty(size_t group) const
+    {
+        // Only empty slots have the top bit set
+        const auto bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(control_.data() + group * groupSize));
+        return static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+    }
+#elif defined(MINIJSON_HASH_NEON)
+    static constexpr size_t groupSize = 16;
+    static constexpr size_t bitsPerSlot = 4;
+
+    static uint64_t toMask(uint8x16_t eq)
+    {
+        // Narrows every byte (0 or 0xff) to a nibble
+        const auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x1111'1111'1111'1111;
+    }
+
+    uint64_t match(size_t group, uint8_t control) const
+    {
+        const auto bytes = vld1q_u8(control_.data() + group * groupSize);
+        return toMask(vceqq_u8(bytes, vdupq_n_u8(control)));
+    }
+
+    uint64_t matchEmpty(size_t group) const
+    {
+        const auto bytes = vld1q_u8(control_.data() + group * groupSize);
+        return toMask(vcltzq_s8(vreinterpretq_s8_u8(bytes)));
+    }
+#else
+    static constexpr size_t groupSize = 8;
+    static constexpr size_t bitsPerSlot = 1;
+
+    template <typename Pred>
+    uint64_t matchBytes(size_t group, Pred pred) const
+    {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < groupSize; ++i) {
+            mask |= static_cast<uint64_t>(pred(control_[group * groupSize + i])) << i;
+        }
+        return mask;
+    }
+
+    uint64_t match(size_t group, uint8_t control) const
+    {
+        return matchBytes(group, [control](uint8_t byte) { return byte == control; });
+    }
+
+    uint64_t matchEmpty(size_t group) const
+    {
+        return matchBytes(group, [](uint8_t byte) { return byte == emptyControl; });
+    }
+#endif
+
+    static constexpr size_t minCapacity = 2 * groupSize;
+
+    static size_t firstIndex(uint64_t mask)
+    {
+        return static_cast<size_t>(__builtin_ctzll(mask)) / bitsPerSlot;
+    }
+    static uint64_t clearFirst(uint64_t mask) { return mask & (mask - 1); }
+
+    size_t numGroups() const { return slots_.size() / groupSize; }
+
+    std::pmr::vector<uint8_t> control_;
+    std::pmr::vector<uint32_t> slots_;
+};
+}
@@ -0,0 +1,349 @@
+#include "minijson_index.hpp"
+
+#include <cstring>
+
+#include "minijson_scan.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MINIJSON_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MINIJSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace minijson;
+using namespace minijson::detail;
+
+namespace {
+// One bit per byte of a 64-byte block
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op; // {}[]:,
+};
+
+bool isOp(char ch)
+{
+    return ch == '{' || ch == '}' || ch == '[' || ch == ']' || ch == ':' || ch == ',';
+}
+
+BlockMasks classifyScalar(const char* block)
+{
+    BlockMasks masks {};
+    for (size_t i = 0; i < 64; ++i) {
+        const auto bit = uint64_t(1) << i;
+        const auto ch = block[i];
+        masks.quote |= ch == '"' ? bit : 0;
+        masks.backslash |= ch == '\\' ? bit : 0;
+        masks.op |= isOp(ch) ? bit : 0;
+    }
+    return masks;
+}
+
+// Every bit is the xor of itself and all bits below it, i.e. it is set between an odd and the
+// next even quote.
+uint64_t prefixXorShift(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+#if defined(MINIJSON_X86)
+BlockMasks classifySse2(const char* block)
+{
+    BlockMasks masks {};
+    for (size_t i = 0; i < 4; ++i) {
+        const auto vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        const auto eq = [&](char ch) { return _mm_cmpeq_epi8(vec, _mm_set1_epi8(ch)); };
+        // '[' | 0x20 == '{' and ']' | 0x20 == '}'
+        const auto folded = _mm_or_si128(vec, _mm_set1_epi8(0x20));
+        const auto brackets = _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')),
+            _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+        const auto op = _mm_or_si128(brackets, _mm_or_si128(eq(':'), eq(',')));
+        const auto shift = i * 16;
+        masks.quote |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(eq('"')))) << shift;
+        masks.backslash
+            |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(eq('\\')))) << shift;
+        masks.op |= uint64_t(static_cast<uint32_t>(_mm_movemask_epi8(op))) << shift;
+    }
+    return masks;
+}
+
+#define MINIJSON_AVX2 __attribute__((target("avx2")))
+#define MINIJSON_AVX2_CLMUL __attribute__((target("avx2,pclmul")))
+
+MINIJSON_AVX2 uint64_t movemask(__m256i lo, __m256i hi)
+{
+    return uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(lo)))
+        | uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32;
+}
+
+// Lambdas can't have the target attribute
+MINIJSON_AVX2 __m256i eq(__m256i vec, char ch)
+{
+    return _mm256_cmpeq_epi8(vec, _mm256_set1_epi8(ch));
+}
+
+MINIJSON_AVX2 __m256i opMask(__m256i vec)
+{
+    const auto folded = _mm256_or_si256(vec, _mm256_set1_epi8(0x20));
+    const auto brackets = _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')),
+        _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}')));
+    return _mm256_or_si256(brackets, _mm256_or_si256(eq(vec, ':'), eq(vec, ',')));
+}
+
+MINIJSON_AVX2 BlockMasks classifyAvx2(const char* block)
+{
+    const auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    BlockMasks masks;
+    masks.quote = movemask(eq(lo, '"'), eq(hi, '"'));
+    masks.backslash = movemask(eq(lo, '\\'), eq(hi, '\\'));
+    masks.op = movemask(opMask(lo), opMask(hi));
+    return masks;
+}
+
+// Carry-less multiplication with all ones computes the prefix xor in a single instruction
+MINIJSON_AVX2_CLMUL uint64_t prefixXorClmul(uint64_t x)
+{
+    const auto product = _mm_clmulepi64_si128(
+        _mm_set_epi64x(0, static_cast<int64_t>(x)), _mm_set1_epi8(static_cast<char>(0xff)), 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+}
+#endif
+
+#if defined(MINIJSON_NEON)
+uint64_t movemask(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+    const uint8x16_t bits = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x01, 0x02, 0x04,
+        0x08, 0x10, 0x20, 0x40, 0x80 };
+    auto sum0 = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+    const auto sum1 = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+    sum0 = vpaddq_u8(sum0, sum1);
+    sum0 = vpaddq_u8(sum0, sum0);
+    return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+BlockMasks classifyNeon(const char* block)
+{
+    uint8x16_t quote[4], backslash[4], op[4];
+    for (size_t i = 0; i < 4; ++i) {
+        const auto vec = vld1q_u8(reinterpret_cast<const uint8_t*>(block + i * 16));
+        const auto eq = [&](char ch) { return vceqq_u8(vec, vdupq_n_u8(ch)); };
+        const auto folded = vorrq_u8(vec, vdupq_n_u8(0x20));
+        const auto brackets
+            = vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}')));
+        quote[i] = eq('"');
+        backslash[i] = eq('\\');
+        op[i] = vorrq_u8(brackets, vorrq_u8(eq(':'), eq(',')));
+    }
+    BlockMasks masks;
+    masks.quote = movemask(quote[0], quote[1], quote[2], quote[3]);
+    masks.backslash = movemask(backslash[0], backslash[1], backslash[2], backslash[3]);
+    masks.op = movemask(op[0], op[1], op[2], op[3]);
+    return masks;
+}
+#endif
+
+// State carried from one block to the next
+struct Carry {
+    uint64_t oddBackslash = 0; // 1 if the previous block ended in an odd run of backslashes
+    uint64_t inString = 0; // all ones if the previous block ended inside of a string
+};
+
+// The characters escaped by a backslash, i.e. those following an odd run of backslashes
+inline __attribute__((always_inline)) uint64_t findEscaped(uint64_t backslash, Carry& carry)
+{
+    constexpr uint64_t evenBits = 0x5555'5555'5555'5555;
+    // An escaped backslash at the start of the block doesn't escape anything
+    backslash &= ~carry.oddBackslash;
+    const auto followsEscape = backslash << 1 | carry.oddBackslash;
+    // Adding the starts of the runs that begin on odd bits carries one past their ends, which
+    // flips the parity of everything after them
+    const auto oddStarts = backslash & ~evenBits & ~followsEscape;
+    uint64_t evenRuns;
+    carry.oddBackslash = __builtin_add_overflow(oddStarts, backslash, &evenRuns) ? 1 : 0;
+    const auto invert = evenRuns << 1;
+    return (evenBits ^ invert) & followsEscape;
+}
+
+// The block at `pos` or a copy padded with spaces (which never matter) if it extends past `end`
+inline __attribute__((always_inline)) const char* getBlock(
+    const char* data, size_t pos, size_t end, char* tail)
+{
+    if (pos + 64 <= end) {
+        return data + pos;
+    }
+    std::memset(tail, ' ', 64);
+    std::memcpy(tail, data + pos, end - pos);
+    return tail;
+}
+
+// Valid JSON only has backslashes in strings, so this doesn't need to know whether `pos` is in one
+bool isEscaped(std::string_view source, size_t pos)
+{
+    size_t numBackslashes = 0;
+    while (pos > numBackslashes && source[pos - numBackslashes - 1] == '\\') {
+        numBackslashes++;
+    }
+    return numBackslashes % 2 == 1;
+}
+
+template <BlockMasks (*Classify)(const char*)>
+inline __attribute__((always_inline)) bool hasOddQuotesImpl(
+    std::string_view source, size_t begin, size_t end)
+{
+    Carry carry;
+    carry.oddBackslash = isEscaped(source, begin) ? 1 : 0;
+    // Only the parity of every bit matters
+    uint64_t quotes = 0;
+    char tail[64];
+    for (auto pos = begin; pos < end; pos += 64) {
+        const auto masks = Classify(getBlock(source.data(), pos, end, tail));
+        quotes ^= masks.quote & ~findEscaped(masks.backslash, carry);
+    }
+    return __builtin_popcountll(quotes) % 2 == 1;
+}
+
+template <BlockMasks (*Classify)(const char*), uint64_t (*PrefixXor)(uint64_t)>
+inline __attribute__((always_inline)) void scanOutlineImpl(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    Carry carry;
+    carry.oddBackslash = isEscaped(source, begin) ? 1 : 0;
+    carry.inString = inString ? ~uint64_t(0) : 0;
+    char tail[64];
+    for (auto pos = begin; pos < end; pos += 64) {
+        const auto block = getBlock(source.data(), pos, end, tail);
+        const auto masks = Classify(block);
+        const auto quotes = masks.quote & ~findEscaped(masks.backslash, carry);
+        const auto inStringMask = PrefixXor(quotes) ^ carry.inString;
+        carry.inString = static_cast<uint64_t>(static_cast<int64_t>(inStringMask) >> 63);
+        auto ops = masks.op & ~inStringMask;
+        while (ops) {
+            const auto i = static_cast<size_t>(__builtin_ctzll(ops));
+            ops &= ops - 1;
+            const auto ch = block[i];
+            if (ch == '[' || ch == '{') {
+                outline.depth++;
+            } else if (ch == ']' || ch == '}') {
+                outline.depth--;
+                if (outline.depth < outline.minDepth) {
+                    outline.minDepth = outline.depth;
+                    outline.commas.clear();
+                }
+            } else if (ch == ',' && outline.depth == outline.minDepth) {
+                outline.commas.push_back(pos + i);
+            }
+        }
+    }
+}
+
+struct Scanners {
+    bool (*hasOddQuotes)(std::string_view, size_t, size_t);
+    void (*scanOutline)(std::string_view, size_t, size_t, bool, ArrayOutline&);
+};
+
+bool hasOddQuotesScalar(std::string_view source, size_t begin, size_t end)
+{
+    return hasOddQuotesImpl<classifyScalar>(source, begin, end);
+}
+
+void scanOutlineScalar(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    scanOutlineImpl<classifyScalar, prefixXorShift>(source, begin, end, inString, outline);
+}
+
+#if defined(MINIJSON_X86)
+bool hasOddQuotesSse2(std::string_view source, size_t begin, size_t end)
+{
+    return hasOddQuotesImpl<classifySse2>(source, begin, end);
+}
+
+void scanOutlineSse2(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    scanOutlineImpl<classifySse2, prefixXorShift>(source, begin, end, inString, outline);
+}
+
+MINIJSON_AVX2 uint64_t prefixXorShiftAvx2(uint64_t x)
+{
+    return prefixXorShift(x);
+}
+
+MINIJSON_AVX2 bool hasOddQuotesAvx2(std::string_view source, size_t begin, size_t end)
+{
+    return hasOddQuotesImpl<classifyAvx2>(source, begin, end);
+}
+
+MINIJSON_AVX2 void scanOutlineAvx2(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    scanOutlineImpl<classifyAvx2, prefixXorShiftAvx2>(source, begin, end, inString, outline);
+}
+
+MINIJSON_AVX2_CLMUL void scanOutlineAvx2Clmul(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    scanOutlineImpl<classifyAvx2, prefixXorClmul>(source, begin, end, inString, outline);
+}
+#endif
+
+#if defined(MINIJSON_NEON)
+bool hasOddQuotesNeon(std::string_view source, size_t begin, size_t end)
+{
+    return hasOddQuotesImpl<classifyNeon>(source, begin, end);
+}
+
+void scanOutlineNeon(
+    std::string_view source, size_t begin, size_t end, bool inString, ArrayOutline& outline)
+{
+    scanOutlineImpl<classifyNeon, prefixXorShift>(source, begin, end, inString, outline);
+}
+#endif
+
+// Follows setSimdLevel, so these can be tested and benchmarked together with the other scanners
+Scanners getScanners()
+{
+    switch (getSimdLevel()) {
+#if defined(MINIJSON_X86)
+    case SimdLevel::Sse2:
+        return { hasOddQuotesSse2, scanOutlineSse2 };
+    case SimdLevel::Avx2: {
+        static const auto hasClmul = __builtin_cpu_supports("pclmul");
+        if (hasClmul) {
+            return { hasOddQuotesAvx2, scanOutlineAvx2Clmul };
+        }
+        return { hasOddQuotesAvx2, scanOutlineAvx2 };
+    }
+#endif
+#if defined(MINIJSON_NEON)
+    case SimdLevel::Neon:
+        return { hasOddQuotesNeon, scanOutlineNeon };
+#endif
+    default:
+        return { hasOddQuotesScalar, scanOutlineScalar };
+    }
+}
+}
+
+namespace minijson::detail {
+bool hasOddQuotes(std::string_view source, size_t begin, size_t end)
+{
+    return getScanners().hasOddQuotes(source, begin, end);
+}
+
+ArrayOutline scanOutline(std::string_view source, size_t begin, size_t end, bool inString)
+{
+    ArrayOutline outline;
+    getScanners().scanOutline(source, begin, end, inString, outline);
+    return outline;
+}
+}
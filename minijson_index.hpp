@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace minijson::detail {
+// Splitting an array (between its brackets) into chunks that can be scanned in parallel: the
+// number of quotes in all the preceding chunks tells whether a chunk starts in a string, which is
+// needed to find its outline. Escapes are handled across the chunk boundaries.
+bool hasOddQuotes(std::string_view source, size_t begin, size_t end);
+
+struct ArrayOutline {
+    // Relative to the depth at the start of the chunk
+    ptrdiff_t depth = 0;
+    ptrdiff_t minDepth = 0;
+    // Positions of the commas at minDepth
+    std::vector<size_t> commas;
+};
+
+// `inString` is whether `begin` is in a string (after the opening quote)
+ArrayOutline scanOutline(std::string_view source, size_t begin, size_t end, bool inString);
+}
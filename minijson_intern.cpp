@@ -0,0 +1,64 @@
+#include "minijson_intern.hpp"
+
+#include <algorithm>
+#include <functional>
+
+namespace minijson {
+KeyInterner::KeyInterner(std::pmr::memory_resource* upstream)
+    : storage_(4096, upstream)
+    , slots_(64)
+{
+}
+
+KeyInterner::KeyInterner(
+    std::initializer_list<std::string_view> keys, std::pmr::memory_resource* upstream)
+    : KeyInterner(upstream)
+{
+    for (const auto key : keys) {
+        intern(key);
+    }
+    freeze();
+}
+
+size_t KeyInterner::findSlot(std::string_view key) const
+{
+    const auto mask = slots_.size() - 1;
+    auto slot = std::hash<std::string_view>()(key) & mask;
+    while (slots_[slot].data() && slots_[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void KeyInterner::grow()
+{
+    std::vector<std::string_view> slots(slots_.size() * 2);
+    std::swap(slots, slots_);
+    for (const auto key : slots) {
+        if (key.data()) {
+            slots_[findSlot(key)] = key;
+        }
+    }
+}
+
+std::optional<std::string_view> KeyInterner::intern(std::string_view key)
+{
+    const auto slot = findSlot(key);
+    if (slots_[slot].data()) {
+        return slots_[slot];
+    }
+    if (frozen_) {
+        return std::nullopt;
+    }
+
+    // Empty keys need some data too, to tell them from empty slots
+    const auto data = static_cast<char*>(storage_.allocate(std::max<size_t>(key.size(), 1), 1));
+    std::copy(key.begin(), key.end(), data);
+    slots_[slot] = std::string_view(data, key.size());
+    // Keep the load factor below 0.5
+    if (++size_ * 2 > slots_.size()) {
+        grow();
+    }
+    return std::string_view(data, key.size());
+}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <initializer_list>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "minijson_arena.hpp"
+
+namespace minijson {
+// Stores a single copy of every distinct key, so objects with the same keys can share them (see
+// ParseOptions::keyInterner). Every key is kept until the interner is destroyed, so inputs with an
+// unbounded set of keys should use a frozen interner (or none).
+class KeyInterner {
+public:
+    explicit KeyInterner(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    // Pre-seeded and frozen
+    KeyInterner(std::initializer_list<std::string_view> keys,
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    KeyInterner(const KeyInterner&) = delete;
+    KeyInterner& operator=(const KeyInterner&) = delete;
+
+    // Returns the stored copy of `key`, which stays valid as long as the interner.
+    // Frozen interners only return keys they already have and nullopt for all others.
+    std::optional<std::string_view> intern(std::string_view key);
+
+    // Afterwards the interner is read-only, so it can be used by many threads at once
+    void freeze() { frozen_ = true; }
+    bool frozen() const { return frozen_; }
+
+    size_t size() const { return size_; }
+
+private:
+    // The slot of `key` or the empty slot where it would go
+    size_t findSlot(std::string_view key) const;
+    void grow();
+
+    Arena storage_;
+    // Empty slots have no data
+    std::vector<std::string_view> slots_;
+    size_t size_ = 0;
+    bool frozen_ = false;
+};
+}
@@ -0,0 +1,423 @@
+#include "minijson_lazy.hpp"
+
+#include <cassert>
+
+#include "minijson_number.hpp"
+#include "minijson_sax.hpp"
+#include "minijson_scan.hpp"
+
+namespace {
+using namespace minijson;
+using namespace minijson::detail;
+
+constexpr auto npos = std::string_view::npos;
+
+size_t skipWhitespace(std::string_view source, size_t pos)
+{
+    if (pos < source.size() && isWhitespace(source[pos])) {
+        return findNonWhitespace(source.data(), source.size(), pos + 1);
+    }
+    return pos;
+}
+
+// `pos` is at the opening quote. Returns the position after the closing quote or npos.
+size_t skipString(std::string_view source, size_t pos)
+{
+    pos++;
+    while (true) {
+        pos = findStringSpecial(source.data(), source.size(), pos);
+        if (pos >= source.size()) {
+            return npos;
+        }
+        if (source[pos] == '"') {
+            return pos + 1;
+        }
+        // Skip the escaped character (control characters are simply skipped too)
+        pos += source[pos] == '\\' ? 2 : 1;
+    }
+}
+
+// Returns the position after the value at `pos` or npos if it is malformed. Containers are only
+// checked for balanced brackets, not for their contents.
+size_t skipValue(std::string_view source, size_t pos)
+{
+    if (pos >= source.size()) {
+        return npos;
+    }
+    const auto c = source[pos];
+    if (c == '"') {
+        return skipString(source, pos);
+    }
+    if (c == '[' || c == '{') {
+        size_t depth = 1;
+        pos++;
+        while (true) {
+            pos = findBracketOrQuote(source.data(), source.size(), pos);
+            if (pos >= source.size()) {
+                return npos;
+            }
+            const auto ch = source[pos];
+            if (ch == '"') {
+                pos = skipString(source, pos);
+                if (pos == npos) {
+                    return npos;
+                }
+            } else if (ch == '[' || ch == '{') {
+                depth++;
+                pos++;
+            } else {
+                pos++;
+                if (--depth == 0) {
+                    return pos;
+                }
+            }
+        }
+    }
+    const auto end = findNonValueChar(source.data(), source.size(), pos);
+    return end > pos ? end : npos;
+}
+
+// For the start of an element (or key) in an array (or object)
+size_t firstElement(std::string_view source, size_t pos)
+{
+    const auto end = source[pos] == '[' ? ']' : '}';
+    pos = skipWhitespace(source, pos + 1);
+    if (pos >= source.size() || source[pos] == end) {
+        return npos;
+    }
+    return pos;
+}
+
+// `pos` is at the key. Returns the start of the value or npos.
+size_t memberValue(std::string_view source, size_t pos)
+{
+    if (source[pos] != '"') {
+        return npos;
+    }
+    pos = skipWhitespace(source, skipString(source, pos));
+    if (pos >= source.size() || source[pos] != ':') {
+        return npos;
+    }
+    pos = skipWhitespace(source, pos + 1);
+    return pos < source.size() ? pos : npos;
+}
+
+size_t nextElement(std::string_view source, size_t pos, bool object)
+{
+    if (object) {
+        pos = memberValue(source, pos);
+        if (pos == npos) {
+            return npos;
+        }
+    }
+    pos = skipWhitespace(source, skipValue(source, pos));
+    if (pos >= source.size() || source[pos] != ',') {
+        return npos;
+    }
+    pos = skipWhitespace(source, pos + 1);
+    return pos < source.size() ? pos : npos;
+}
+
+bool matchLiteral(std::string_view source, size_t pos, std::string_view literal)
+{
+    const auto end = pos + literal.size();
+    return source.compare(pos, literal.size(), literal) == 0
+        && (end >= source.size() || !isValueChar(source[end]));
+}
+
+bool lexNumber(std::string_view source, size_t pos, LexedNumber& number)
+{
+    const auto end = source.data() + source.size();
+    const auto numEnd = detail::lexNumber(source.data() + pos, end, number);
+    return numEnd && (numEnd == end || !isValueChar(*numEnd));
+}
+
+// Strings with escapes are decoded by the regular parser
+struct StringHandler : SaxHandler {
+    bool onString(std::string_view str)
+    {
+        value = String(str);
+        return true;
+    }
+
+    String value;
+};
+
+std::optional<String> parseString(std::string_view source, size_t pos)
+{
+    const auto end = skipString(source, pos);
+    if (end == npos) {
+        return std::nullopt;
+    }
+    const auto str = source.substr(pos + 1, end - pos - 2);
+    if (str.find('\\') == npos) {
+        return String::ref(str);
+    }
+    StringHandler handler;
+    if (!detail::runSax(source.substr(pos, end - pos), handler, {}, nullptr)) {
+        return std::nullopt;
+    }
+    return std::move(handler.value);
+}
+
+// Compares the key at `pos` to `key` without decoding it if possible
+bool keyEquals(std::string_view source, size_t pos, std::string_view key)
+{
+    const auto end = skipString(source, pos);
+    if (end == npos) {
+        return false;
+    }
+    const auto raw = source.substr(pos + 1, end - pos - 2);
+    if (raw.find('\\') == npos) {
+        return raw == key;
+    }
+    const auto decoded = parseString(source, pos);
+    return decoded && decoded->view() == key;
+}
+}
+
+namespace minijson::lazy {
+JsonValue::Type Value::type() const
+{
+    if (pos_ >= source_.size()) {
+        return JsonValue::Type::Invalid;
+    }
+    switch (source_[pos_]) {
+    case 'n':
+        return matchLiteral(source_, pos_, "null") ? JsonValue::Type::Null
+                                                   : JsonValue::Type::Invalid;
+    case 't':
+        return matchLiteral(source_, pos_, "true") ? JsonValue::Type::Bool
+                                                   : JsonValue::Type::Invalid;
+    case 'f':
+        return matchLiteral(source_, pos_, "false") ? JsonValue::Type::Bool
+                                                    : JsonValue::Type::Invalid;
+    case '"':
+        return JsonValue::Type::String;
+    case '[':
+        return JsonValue::Type::Array;
+    case '{':
+        return JsonValue::Type::Object;
+    default: {
+        LexedNumber number;
+        return lexNumber(source_, pos_, number) ? JsonValue::Type::Number
+                                                : JsonValue::Type::Invalid;
+    }
+    }
+}
+
+bool Value::isInt() const
+{
+    LexedNumber number;
+    return pos_ < source_.size() && lexNumber(source_, pos_, number)
+        && number.kind == LexedNumber::Kind::Int;
+}
+
+bool Value::isUInt() const
+{
+    LexedNumber number;
+    return pos_ < source_.size() && lexNumber(source_, pos_, number)
+        && number.kind == LexedNumber::Kind::UInt;
+}
+
+bool Value::asBool() const
+{
+    const auto b = toBool();
+    assert(b);
+    return b.value_or(false);
+}
+
+double Value::asNumber() const
+{
+    const auto n = toNumber();
+    assert(n);
+    return n.value_or(0.0);
+}
+
+int64_t Value::asInt() const
+{
+    const auto i = toInt();
+    assert(i);
+    return i.value_or(0);
+}
+
+uint64_t Value::asUInt() const
+{
+    const auto u = toUInt();
+    assert(u);
+    return u.value_or(0);
+}
+
+String Value::asString() const
+{
+    auto str = toString();
+    assert(str);
+    return str ? std::move(*str) : String();
+}
+
+Value::ArrayView Value::asArray() const
+{
+    assert(isArray());
+    const auto end = Iterator(source_, npos, false);
+    return ArrayView(isArray() ? Iterator(source_, firstElement(source_, pos_), false) : end, end);
+}
+
+Value::ObjectView Value::asObject() const
+{
+    assert(isObject());
+    const auto end = Iterator(source_, npos, true);
+    return ObjectView(
+        isObject() ? Iterator(source_, firstElement(source_, pos_), true) : end, end);
+}
+
+std::optional<bool> Value::toBool() const
+{
+    if (!isBool()) {
+        return std::nullopt;
+    }
+    return source_[pos_] == 't';
+}
+
+std::optional<double> Value::toNumber() const
+{
+    LexedNumber number;
+    if (pos_ >= source_.size() || !lexNumber(source_, pos_, number)) {
+        return std::nullopt;
+    }
+    if (number.kind == LexedNumber::Kind::Int) {
+        return static_cast<double>(number.i);
+    } else if (number.kind == LexedNumber::Kind::UInt) {
+        return static_cast<double>(number.u);
+    }
+    return number.d;
+}
+
+std::optional<int64_t> Value::toInt() const
+{
+    LexedNumber number;
+    if (pos_ >= source_.size() || !lexNumber(source_, pos_, number)
+        || number.kind != LexedNumber::Kind::Int) {
+        return std::nullopt;
+    }
+    return number.i;
+}
+
+std::optional<uint64_t> Value::toUInt() const
+{
+    LexedNumber number;
+    if (pos_ >= source_.size() || !lexNumber(source_, pos_, number)
+        || number.kind != LexedNumber::Kind::UInt) {
+        return std::nullopt;
+    }
+    return number.u;
+}
+
+std::optional<String> Value::toString() const
+{
+    if (!isString()) {
+        return std::nullopt;
+    }
+    return parseString(source_, pos_);
+}
+
+size_t Value::size() const
+{
+    const auto t = type();
+    if (t == JsonValue::Type::Invalid || t == JsonValue::Type::Null) {
+        return 0;
+    } else if (t != JsonValue::Type::Array && t != JsonValue::Type::Object) {
+        return 1;
+    }
+    const auto object = t == JsonValue::Type::Object;
+    size_t count = 0;
+    for (auto pos = firstElement(source_, pos_); pos != npos;
+         pos = nextElement(source_, pos, object)) {
+        count++;
+    }
+    return count;
+}
+
+Value Value::operator[](std::string_view key) const
+{
+    if (!isObject()) {
+        return Value();
+    }
+    for (auto pos = firstElement(source_, pos_); pos != npos; pos = nextElement(source_, pos, true)) {
+        if (keyEquals(source_, pos, key)) {
+            const auto valuePos = memberValue(source_, pos);
+            return valuePos != npos ? Value(source_, valuePos) : Value();
+        }
+    }
+    return Value();
+}
+
+Value Value::operator[](size_t index) const
+{
+    if (!isArray()) {
+        return Value();
+    }
+    size_t i = 0;
+    for (auto pos = firstElement(source_, pos_); pos != npos;
+         pos = nextElement(source_, pos, false)) {
+        if (i++ == index) {
+            return Value(source_, pos);
+        }
+    }
+    return Value();
+}
+
+std::string_view Value::raw() const
+{
+    if (pos_ >= source_.size()) {
+        return {};
+    }
+    const auto end = skipValue(source_, pos_);
+    return end != npos ? source_.substr(pos_, end - pos_) : std::string_view();
+}
+
+Result<JsonValue> Value::materialize(
+    std::pmr::memory_resource* memRes, const ParseOptions& options) const
+{
+    if (pos_ >= source_.size()) {
+        return Error { ErrorCode::ExpectedValue, pos_ == npos ? 0 : pos_ };
+    }
+    // Parse from the value to the end of the source, so error cursors stay meaningful
+    DomBuilder builder(source_, memRes, options);
+    const auto sub = source_.substr(pos_);
+    const auto res = parseSax(sub, builder, options);
+    if (!res) {
+        return Error { res.error().code, pos_ + res.error().cursor };
+    }
+    return std::move(builder.root());
+}
+
+Value Value::Iterator::value() const
+{
+    if (!object_) {
+        return Value(source_, pos_);
+    }
+    const auto pos = memberValue(source_, pos_);
+    return pos != npos ? Value(source_, pos) : Value();
+}
+
+String Value::Iterator::key() const
+{
+    assert(object_);
+    return parseString(source_, pos_).value_or(String());
+}
+
+Value::Iterator& Value::Iterator::operator++()
+{
+    pos_ = nextElement(source_, pos_, object_);
+    return *this;
+}
+
+Result<Value> parse(std::string_view source)
+{
+    const auto pos = skipWhitespace(source, 0);
+    if (pos >= source.size()) {
+        return Error { ErrorCode::ExpectedValue, pos };
+    }
+    return Value(source, pos);
+}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+
+#include "minijson.hpp"
+
+// On-demand parsing: values are only parsed when they are accessed and everything that is not
+// needed on the way is skipped with a scan that just balances brackets and quotes.
+// Malformed input is only detected when (and if) it is reached and then shows up as invalid
+// values (or ends the iteration early), like a missing key would.
+// Nothing is cached, so every access scans from the start of its value again. Iterate instead of
+// indexing in a loop.
+// Values refer to the source, which has to outlive them.
+namespace minijson::lazy {
+class Value {
+public:
+    class Iterator;
+    struct Member;
+    class ArrayView;
+    class ObjectView;
+
+    Value() = default; // invalid
+
+    JsonValue::Type type() const;
+
+    bool isValid() const { return type() != JsonValue::Type::Invalid; }
+    bool isNull() const { return type() == JsonValue::Type::Null; }
+    bool isBool() const { return type() == JsonValue::Type::Bool; }
+    bool isNumber() const { return type() == JsonValue::Type::Number; }
+    bool isInteger() const { return isInt() || isUInt(); }
+    bool isInt() const;
+    bool isUInt() const;
+    bool isString() const { return type() == JsonValue::Type::String; }
+    bool isArray() const { return type() == JsonValue::Type::Array; }
+    bool isObject() const { return type() == JsonValue::Type::Object; }
+
+    // Unlike JsonValue these do not throw, but assert the type
+    bool asBool() const;
+    // Converts Int and UInt, which might lose precision
+    double asNumber() const;
+    int64_t asInt() const;
+    uint64_t asUInt() const;
+    // Refers to the source, unless the string contains escapes
+    String asString() const;
+    ArrayView asArray() const;
+    ObjectView asObject() const;
+
+    // These return nullopt if the value has a different type or is malformed
+    std::optional<bool> toBool() const;
+    std::optional<double> toNumber() const;
+    std::optional<int64_t> toInt() const;
+    std::optional<uint64_t> toUInt() const;
+    std::optional<String> toString() const;
+
+    // 0 for null and invalid, number of elements for array and object, 1 otherwise
+    size_t size() const;
+
+    // returns an invalid Value if the key/index does not exist
+    Value operator[](std::string_view key) const;
+    Value operator[](size_t index) const;
+
+    // The text of the whole value in the source (empty if it is invalid)
+    std::string_view raw() const;
+
+    // Fully parses the value
+    Result<JsonValue> materialize(
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource(),
+        const ParseOptions& options = {}) const;
+
+private:
+    friend class Iterator;
+    friend Result<Value> parse(std::string_view source);
+
+    Value(std::string_view source, size_t pos) : source_(source), pos_(pos) { }
+
+    std::string_view source_;
+    // Position of the first character of the value
+    size_t pos_ = std::string_view::npos;
+};
+
+struct Value::Member {
+    String key;
+    Value value;
+};
+
+// Iterates over the elements of an array or the members of an object
+class Value::Iterator {
+public:
+    // The element of an array or the value of an object member
+    Value value() const;
+    // Only for objects
+    String key() const;
+
+    Iterator& operator++();
+
+    bool operator==(const Iterator& other) const { return pos_ == other.pos_; }
+    bool operator!=(const Iterator& other) const { return pos_ != other.pos_; }
+
+private:
+    friend class Value;
+
+    Iterator(std::string_view source, size_t pos, bool object)
+        : source_(source), pos_(pos), object_(object)
+    {
+    }
+
+    std::string_view source_;
+    // Start of the element (or the key for objects) or npos at the end
+    size_t pos_;
+    bool object_;
+};
+
+class Value::ArrayView {
+public:
+    class ConstIterator : public Iterator {
+    public:
+        ConstIterator(Iterator it) : Iterator(it) { }
+        Value operator*() const { return value(); }
+    };
+
+    ArrayView(Iterator begin, Iterator end) : begin_(begin), end_(end) { }
+    ConstIterator begin() const { return begin_; }
+    ConstIterator end() const { return end_; }
+
+private:
+    Iterator begin_;
+    Iterator end_;
+};
+
+class Value::ObjectView {
+public:
+    class ConstIterator : public Iterator {
+    public:
+        ConstIterator(Iterator it) : Iterator(it) { }
+        Member operator*() const { return Member { key(), value() }; }
+    };
+
+    ObjectView(Iterator begin, Iterator end) : begin_(begin), end_(end) { }
+    ConstIterator begin() const { return begin_; }
+    ConstIterator end() const { return end_; }
+
+private:
+    Iterator begin_;
+    Iterator end_;
+};
+
+// Only locates the root value, so this fails only if there is no value at all
+Result<Value> parse(std::string_view source);
+}
@@ -0,0 +1,93 @@
+#include "minijson_ndjson.hpp"
+
+#include <cstring>
+
+#include "minijson_parallel.hpp"
+#include "minijson_sax.hpp"
+
+namespace {
+using namespace minijson;
+
+struct Line {
+    size_t offset;
+    size_t number;
+    std::string_view source;
+};
+
+// Newlines can't appear unescaped inside of JSON strings, so we can split without parsing.
+// memchr is vectorized in every libc that matters.
+std::vector<Line> splitLines(std::string_view source)
+{
+    std::vector<Line> lines;
+    size_t offset = 0;
+    size_t number = 1;
+    while (offset < source.size()) {
+        const auto newline = static_cast<const char*>(
+            std::memchr(source.data() + offset, '\n', source.size() - offset));
+        const auto end = newline ? static_cast<size_t>(newline - source.data()) : source.size();
+        const auto line = source.substr(offset, end - offset);
+        if (detail::findNonWhitespace(line.data(), line.size(), 0) < line.size()) {
+            lines.push_back(Line { offset, number, line });
+        }
+        offset = end + 1;
+        number++;
+    }
+    return lines;
+}
+
+Result<JsonValue> parseLine(
+    const Line& line, std::pmr::memory_resource* memRes, const ParseOptions& options)
+{
+    DomBuilder builder(line.source, memRes, options);
+    const auto res = detail::runSax(line.source, builder, options, nullptr);
+    if (!res) {
+        const auto& error = res.error();
+        return Error { error.code, line.offset + error.cursor };
+    }
+    const auto end = detail::findNonWhitespace(line.source.data(), line.source.size(), *res);
+    if (end < line.source.size()) {
+        return Error { ErrorCode::TrailingCharacters, line.offset + end };
+    }
+    return std::move(builder.root());
+}
+}
+
+namespace minijson {
+bool NdjsonResult::allValid() const
+{
+    for (const auto& record : records_) {
+        if (!record.value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+NdjsonResult parseNdjson(std::string_view source, const NdjsonOptions& options)
+{
+    const auto lines = splitLines(source);
+
+    NdjsonResult result;
+    // Interners that are not frozen can't be shared between threads
+    const auto interner = options.parse.keyInterner;
+    const auto numThreads
+        = interner && !interner->frozen() ? 1 : detail::getNumThreads(options.numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        result.memResources_.push_back(std::make_unique<std::pmr::monotonic_buffer_resource>());
+    }
+
+    result.records_.reserve(lines.size());
+    for (const auto& line : lines) {
+        result.records_.push_back(NdjsonRecord { line.number, JsonValue() });
+    }
+
+    detail::parallelFor(lines.size(), options.batchSize, numThreads,
+        [&](size_t worker, size_t begin, size_t end) {
+            auto memRes = result.memResources_[worker].get();
+            for (size_t i = begin; i < end; ++i) {
+                result.records_[i].value = parseLine(lines[i], memRes, options.parse);
+            }
+        });
+    return result;
+}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+#include "minijson.hpp"
+
+namespace minijson {
+struct NdjsonOptions {
+    ParseOptions parse;
+    // 0 means std::thread::hardware_concurrency(). A KeyInterner that is not frozen forces 1.
+    size_t numThreads = 0;
+    // Number of records a worker claims at once
+    size_t batchSize = 256;
+};
+
+struct NdjsonRecord {
+    // 1-based line number in the source
+    size_t line;
+    // Error cursors are offsets into the whole source
+    Result<JsonValue> value;
+};
+
+// Owns the records and the memory resources (one per worker) they are allocated from
+class NdjsonResult {
+public:
+    using Records = std::vector<NdjsonRecord>;
+
+    size_t size() const { return records_.size(); }
+    const NdjsonRecord& operator[](size_t index) const { return records_[index]; }
+    Records::const_iterator begin() const { return records_.begin(); }
+    Records::const_iterator end() const { return records_.end(); }
+
+    // Whether every record was parsed successfully
+    bool allValid() const;
+
+private:
+    friend NdjsonResult parseNdjson(std::string_view source, const NdjsonOptions& options);
+
+    std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> memResources_;
+    Records records_;
+};
+
+// Parses newline-delimited JSON (JSON Lines), i.e. one value per line. Lines that only contain
+// whitespace are skipped. The records are returned in input order.
+NdjsonResult parseNdjson(std::string_view source, const NdjsonOptions& options = {});
+}
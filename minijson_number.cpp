@@ -0,0 +1,160 @@
+#include "minijson_number.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <limits>
+
+namespace {
+bool isDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+// All of these are exactly representable as doubles
+constexpr double powersOfTen[] = {
+    1e0,
+    1e1,
+    1e2,
+    1e3,
+    1e4,
+    1e5,
+    1e6,
+    1e7,
+    1e8,
+    1e9,
+    1e10,
+    1e11,
+    1e12,
+    1e13,
+    1e14,
+    1e15,
+    1e16,
+    1e17,
+    1e18,
+    1e19,
+    1e20,
+    1e21,
+    1e22,
+};
+}
+
+namespace minijson::detail {
+const char* lexNumber(const char* begin, const char* end, LexedNumber& number)
+{
+    auto p = begin;
+    const auto negative = p < end && *p == '-';
+    if (negative) {
+        p++;
+    }
+    if (p >= end || !isDigit(*p)) {
+        return nullptr;
+    }
+
+    // We accumulate as many digits as fit into the mantissa and track the decimal exponent.
+    uint64_t mantissa = 0;
+    int64_t exponent = 0;
+    // If there are more digits than fit, we have to leave it to from_chars
+    bool truncated = false;
+    const auto addDigit = [&](char ch) {
+        const auto digit = static_cast<uint64_t>(ch - '0');
+        constexpr auto max = std::numeric_limits<uint64_t>::max();
+        if (mantissa <= (max - digit) / 10) {
+            mantissa = mantissa * 10 + digit;
+            return true;
+        }
+        truncated = true;
+        return false;
+    };
+
+    // No leading zeros
+    if (*p == '0') {
+        p++;
+    } else {
+        while (p < end && isDigit(*p)) {
+            if (!addDigit(*p)) {
+                exponent++;
+            }
+            p++;
+        }
+    }
+
+    bool isInteger = true;
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !isDigit(*p)) {
+            return nullptr;
+        }
+        isInteger = false;
+        while (p < end && isDigit(*p)) {
+            if (!truncated && addDigit(*p)) {
+                exponent--;
+            }
+            p++;
+        }
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        isInteger = false;
+        bool negativeExponent = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negativeExponent = *p == '-';
+            p++;
+        }
+        if (p >= end || !isDigit(*p)) {
+            return nullptr;
+        }
+        int64_t exp = 0;
+        while (p < end && isDigit(*p)) {
+            // Anything this large is out of range anyway
+            if (exp < 1'000'000) {
+                exp = exp * 10 + (*p - '0');
+            }
+            p++;
+        }
+        exponent += negativeExponent ? -exp : exp;
+    }
+
+    if (isInteger && !truncated) {
+        constexpr auto maxInt = static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+        if (!negative) {
+            if (mantissa <= maxInt) {
+                number.kind = LexedNumber::Kind::Int;
+                number.i = static_cast<int64_t>(mantissa);
+            } else {
+                number.kind = LexedNumber::Kind::UInt;
+                number.u = mantissa;
+            }
+            return p;
+        } else if (mantissa != 0 && mantissa <= maxInt + 1) {
+            number.kind = LexedNumber::Kind::Int;
+            // Negate as unsigned, so -2^63 doesn't overflow
+            number.i = static_cast<int64_t>(~mantissa + 1);
+            return p;
+        }
+        // -0 and anything below INT64_MIN are doubles
+    }
+
+    number.kind = LexedNumber::Kind::Double;
+
+    // Clinger's fast path: if both the mantissa and the power of ten are exactly representable,
+    // a single multiplication/division is correctly rounded.
+    if (!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        auto value = static_cast<double>(mantissa);
+        if (exponent < 0) {
+            value /= powersOfTen[-exponent];
+        } else {
+            value *= powersOfTen[exponent];
+        }
+        number.d = negative ? -value : value;
+        return p;
+    }
+
+    // We have already validated the grammar, so from_chars can only fail for out of range values
+    const auto [ptr, ec] = std::from_chars(begin, p, number.d);
+    if (ec != std::errc() || ptr != p) {
+        return nullptr;
+    }
+    return p;
+}
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+namespace minijson::detail {
+struct LexedNumber {
+    enum class Kind { Int, UInt, Double };
+
+    Kind kind;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+    };
+};
+
+// Lexes a number according to the JSON grammar starting at `begin` in a single pass.
+// Integers (no fraction or exponent) that fit into int64_t/uint64_t are returned exactly
+// (UInt only if they don't fit into an int64_t).
+// Returns the end of the number or nullptr if there is no valid number at `begin`.
+// It does not check what comes after the number.
+const char* lexNumber(const char* begin, const char* end, LexedNumber& number);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace minijson::detail {
+inline size_t getNumThreads(size_t requested)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls func(workerIndex, begin, end) for batches of [0, count) on up to numThreads threads.
+// The batches are handed out dynamically, so slow batches don't hold up the other workers.
+// The calling thread is used as one of the workers.
+template <typename Func>
+void parallelFor(size_t count, size_t batchSize, size_t numThreads, Func&& func)
+{
+    batchSize = std::max<size_t>(batchSize, 1);
+    const auto numBatches = (count + batchSize - 1) / batchSize;
+    numThreads = std::min(getNumThreads(numThreads), numBatches);
+
+    std::atomic<size_t> nextBatch { 0 };
+    const auto work = [&](size_t workerIndex) {
+        while (true) {
+            const auto batch = nextBatch.fetch_add(1, std::memory_order_relaxed);
+            if (batch >= numBatches) {
+                return;
+            }
+            const auto begin = batch * batchSize;
+            func(workerIndex, begin, std::min(begin + batchSize, count));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (size_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+}
@@ -0,0 +1,99 @@
+#include "minijson_pointer.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr auto npos = std::string_view::npos;
+
+// RFC 6901 only allows "0" and decimal numbers without leading zeros
+size_t parseIndex(std::string_view token)
+{
+    if (token.empty() || (token[0] == '0' && token.size() > 1)) {
+        return npos;
+    }
+    size_t index = 0;
+    for (const auto c : token) {
+        if (c < '0' || c > '9' || index > (std::numeric_limits<size_t>::max() - 9) / 10) {
+            return npos;
+        }
+        index = index * 10 + static_cast<size_t>(c - '0');
+    }
+    return index;
+}
+}
+
+namespace minijson {
+Result<JsonPointer> JsonPointer::compile(std::string_view pointer)
+{
+    JsonPointer compiled;
+    if (pointer.empty()) {
+        return compiled;
+    }
+    if (pointer[0] != '/') {
+        // It has to start with '/'
+        return Error { ErrorCode::InvalidPointer, 0 };
+    }
+
+    size_t pos = 1;
+    while (true) {
+        const auto end = std::min(pointer.find('/', pos), pointer.size());
+        std::string key;
+        key.reserve(end - pos);
+        for (auto i = pos; i < end; ++i) {
+            if (pointer[i] != '~') {
+                key.push_back(pointer[i]);
+            } else if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+                key.push_back(pointer[++i] == '0' ? '~' : '/');
+            } else {
+                return Error { ErrorCode::InvalidPointer, i };
+            }
+        }
+        const auto hash = JsonValue::Object::hashKey(key);
+        const auto index = parseIndex(key);
+        compiled.tokens_.push_back(Token { std::move(key), hash, index });
+        if (end == pointer.size()) {
+            return compiled;
+        }
+        pos = end + 1;
+    }
+}
+
+const JsonValue* JsonPointer::evaluate(const JsonValue& root) const
+{
+    auto value = &root;
+    for (const auto& token : tokens_) {
+        if (const auto object = value->toObject()) {
+            const auto it = object->find(token.key, token.hash);
+            if (it == object->end()) {
+                return nullptr;
+            }
+            value = &it->second;
+        } else if (const auto array = value->toArray()) {
+            if (token.index >= array->size()) {
+                return nullptr;
+            }
+            value = &(*array)[token.index];
+        } else {
+            return nullptr;
+        }
+    }
+    return value->isValid() ? value : nullptr;
+}
+
+lazy::Value JsonPointer::evaluate(const lazy::Value& root) const
+{
+    auto value = root;
+    for (const auto& token : tokens_) {
+        const auto type = value.type();
+        if (type == JsonValue::Type::Object) {
+            value = value[std::string_view(token.key)];
+        } else if (type == JsonValue::Type::Array && token.index != npos) {
+            value = value[token.index];
+        } else {
+            return lazy::Value();
+        }
+    }
+    return value;
+}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "minijson.hpp"
+#include "minijson_lazy.hpp"
+
+namespace minijson {
+// A JSON Pointer (RFC 6901), e.g. "/a/b/0/c". It is split, unescaped and prepared once, so it can
+// be evaluated many times cheaply.
+class JsonPointer {
+public:
+    // The empty pointer refers to the root
+    JsonPointer() = default;
+
+    // Fails if the pointer is not empty and doesn't start with '/' or if it contains a '~' that
+    // is not followed by '0' or '1'
+    static Result<JsonPointer> compile(std::string_view pointer);
+
+    // nullptr if the value does not exist
+    const JsonValue* evaluate(const JsonValue& root) const;
+    // Invalid if the value does not exist
+    lazy::Value evaluate(const lazy::Value& root) const;
+
+    // The number of reference tokens
+    size_t size() const { return tokens_.size(); }
+    // Unescaped
+    std::string_view token(size_t index) const { return tokens_[index].key; }
+
+private:
+    struct Token {
+        std::string key;
+        size_t hash;
+        // npos if the token is not a valid array index
+        size_t index;
+    };
+
+    std::vector<Token> tokens_;
+};
+}
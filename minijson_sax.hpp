@@ -0,0 +1,764 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "minijson.hpp"
+#include "minijson_intern.hpp"
+#include "minijson_number.hpp"
+#include "minijson_scan.hpp"
+#include "minijson_stats.hpp"
+#include "minijson_unicode.hpp"
+
+namespace minijson {
+// Handlers passed to parseSax have to provide all of these callbacks. Each of them returns whether
+// parsing should continue. Deriving from SaxHandler provides defaults, which ignore everything.
+// Handlers may additionally provide onInt(int64_t) and onUInt(uint64_t) to receive integers
+// exactly (see JsonValue::Int). Otherwise they are passed to onNumber.
+// The string views passed to onString and onKey point into the source if the string does not
+// contain escapes and into a temporary buffer, which is only valid during the call, otherwise.
+struct SaxHandler {
+    bool onNull() { return true; }
+    bool onBool(bool) { return true; }
+    bool onNumber(double) { return true; }
+    bool onString(std::string_view) { return true; }
+    bool onKey(std::string_view) { return true; }
+    bool onStartArray() { return true; }
+    bool onEndArray(size_t /*numElements*/) { return true; }
+    bool onStartObject() { return true; }
+    bool onEndObject(size_t /*numMembers*/) { return true; }
+};
+
+namespace detail {
+    template <typename Handler, typename = void>
+    struct HasIntCallbacks : std::false_type { };
+
+    template <typename Handler>
+    struct HasIntCallbacks<Handler,
+        std::void_t<decltype(std::declval<Handler&>().onInt(int64_t())),
+            decltype(std::declval<Handler&>().onUInt(uint64_t()))>> : std::true_type { };
+
+    // Handlers without onInt and onUInt get all numbers as doubles
+    template <typename Handler>
+    bool emitNumber(Handler& handler, const LexedNumber& number)
+    {
+        if constexpr (HasIntCallbacks<Handler>::value) {
+            if (number.kind == LexedNumber::Kind::Int) {
+                return handler.onInt(number.i);
+            } else if (number.kind == LexedNumber::Kind::UInt) {
+                return handler.onUInt(number.u);
+            }
+        } else {
+            if (number.kind == LexedNumber::Kind::Int) {
+                return handler.onNumber(static_cast<double>(number.i));
+            } else if (number.kind == LexedNumber::Kind::UInt) {
+                return handler.onNumber(static_cast<double>(number.u));
+            }
+        }
+        return handler.onNumber(number.d);
+    }
+
+    template <typename Handler>
+    class SaxParser {
+    public:
+        SaxParser(std::string_view source, Handler& handler, size_t maxDepth)
+            : source_(source), handler_(handler), maxDepth_(maxDepth)
+        {
+        }
+
+        // Parses one value. Nested values are handled with an explicit stack instead of recursion,
+        // so the nesting depth is only limited by maxDepth.
+        // Returns false if there was an error or the handler stopped parsing.
+        bool parse()
+        {
+            auto step = Step::Value;
+            while (true) {
+                switch (step) {
+                case Step::Value:
+                    if (!parseValue(step)) {
+                        return false;
+                    }
+                    break;
+                case Step::AfterValue:
+                    if (levels_.empty()) {
+                        return true;
+                    }
+                    levels_.back().count++;
+                    step = levels_.back().isObject ? Step::ObjectNext : Step::ArrayNext;
+                    break;
+                case Step::ArrayFirst:
+                case Step::ObjectFirst:
+                    skipWhitespace();
+                    if (cursor_ >= source_.size()) {
+                        return fail(step == Step::ArrayFirst ? ErrorCode::UnterminatedArray
+                                                             : ErrorCode::UnterminatedObject);
+                    }
+                    if (source_[cursor_] == (step == Step::ArrayFirst ? ']' : '}')) {
+                        cursor_++;
+                        step = Step::End;
+                    } else if (step == Step::ArrayFirst) {
+                        step = Step::Value;
+                    } else if (!parseKey()) {
+                        return false;
+                    } else {
+                        step = Step::Value;
+                    }
+                    break;
+                case Step::ArrayNext:
+                case Step::ObjectNext: {
+                    const auto separatorFound = skipSeparator();
+                    const auto end = step == Step::ArrayNext ? ']' : '}';
+                    const auto atEnd = cursor_ < source_.size() && source_[cursor_] == end;
+                    if (atEnd && separatorFound) {
+                        return fail(ErrorCode::TrailingComma);
+                    } else if (atEnd) {
+                        cursor_++;
+                        step = Step::End;
+                    } else if (!separatorFound) {
+                        return fail(ErrorCode::ExpectedSeparator);
+                    } else {
+                        step = step == Step::ArrayNext ? Step::ArrayFirst : Step::ObjectFirst;
+                    }
+                    break;
+                }
+                case Step::End: {
+                    const auto level = levels_.back();
+                    levels_.pop_back();
+                    const auto cont = level.isObject ? handler_.onEndObject(level.count)
+                                                     : handler_.onEndArray(level.count);
+                    if (!cont) {
+                        return stopped();
+                    }
+                    step = Step::AfterValue;
+                    break;
+                }
+                }
+            }
+        }
+
+        size_t cursor() const { return cursor_; }
+        Error& error() { return error_; }
+
+        void setValidateUtf8(bool validate) { validateUtf8_ = validate; }
+
+        // Only used with MINIJSON_ENABLE_STATS
+        void setStats(ParseStats& stats) { stats_ = &stats; }
+
+    private:
+        enum class Step { Value, AfterValue, ArrayFirst, ArrayNext, ObjectFirst, ObjectNext, End };
+
+        struct Level {
+            bool isObject;
+            size_t count;
+        };
+
+        bool fail(ErrorCode code)
+        {
+            error_ = Error { code, cursor_ };
+            return false;
+        }
+
+        bool stopped() { return fail(ErrorCode::StoppedByHandler); }
+
+        template <typename Func>
+        void count(Func&& func)
+        {
+            if constexpr (statsEnabled) {
+                if (stats_) {
+                    func(*stats_);
+                }
+            }
+        }
+
+        void skipWhitespace()
+        {
+            // Often there is no whitespace at all, so check the first character before scanning
+            if (cursor_ < source_.size() && isWhitespace(source_[cursor_])) {
+                cursor_ = findNonWhitespace(source_.data(), source_.size(), cursor_ + 1);
+            }
+        }
+
+        bool skipSeparator()
+        {
+            skipWhitespace();
+            if (cursor_ < source_.size() && source_[cursor_] == ',') {
+                cursor_++;
+                skipWhitespace();
+                return true;
+            }
+            return false;
+        }
+
+        // Skips to the next character that cannot be part of a string as-is. Fails if the
+        // skipped characters are not valid UTF-8 (only if that is checked), while they are still
+        // in the cache.
+        bool skipStringChars()
+        {
+            const auto start = cursor_;
+            cursor_ = findStringSpecial(source_.data(), source_.size(), cursor_);
+            // Control characters are not actually allowed in strings, but we have always
+            // accepted them
+            while (
+                cursor_ < source_.size() && source_[cursor_] != '"' && source_[cursor_] != '\\') {
+                cursor_ = findStringSpecial(source_.data(), source_.size(), cursor_ + 1);
+            }
+            if (validateUtf8_) {
+                const auto invalid = findInvalidUtf8(source_.data(), cursor_, start);
+                if (invalid < cursor_) {
+                    cursor_ = invalid;
+                    return fail(ErrorCode::InvalidUtf8);
+                }
+            }
+            return true;
+        }
+
+        bool emitString(std::string_view str, bool isKey)
+        {
+            if (!(isKey ? handler_.onKey(str) : handler_.onString(str))) {
+                return stopped();
+            }
+            return true;
+        }
+
+        bool parseString(bool isKey)
+        {
+            assert(cursor_ < source_.size());
+            assert(source_[cursor_] == '"');
+            cursor_++;
+            count([&](ParseStats& stats) { (isKey ? stats.keys : stats.strings)++; });
+
+            // Most strings don't contain any escapes, so they can be passed on from the source
+            // directly.
+            auto start = cursor_;
+            if (!skipStringChars()) {
+                return false;
+            }
+            if (cursor_ >= source_.size()) {
+                return fail(ErrorCode::UnterminatedString);
+            }
+            if (source_[cursor_] == '"') {
+                const auto str = source_.substr(start, cursor_ - start);
+                cursor_++;
+                return emitString(str, isKey);
+            }
+
+            count([](ParseStats& stats) { stats.escapedStrings++; });
+            scratch_.assign(source_.substr(start, cursor_ - start));
+            while (cursor_ < source_.size()) {
+                if (source_[cursor_] == '\\') {
+                    cursor_++;
+                    if (cursor_ >= source_.size()) {
+                        return fail(ErrorCode::UnterminatedString);
+                    }
+                    const auto c = source_[cursor_];
+                    if (const auto decoded = escapeTable[static_cast<unsigned char>(c)]) {
+                        scratch_.push_back(decoded);
+                        cursor_++;
+                    } else if (c == 'u') {
+                        const auto end = source_.data() + source_.size();
+                        uint32_t codePoint;
+                        const auto length
+                            = decodeUnicodeEscape(source_.data() + cursor_ + 1, end, codePoint);
+                        if (length == 0) {
+                            return fail(ErrorCode::InvalidUnicodeEscape);
+                        }
+                        appendUtf8(scratch_, codePoint);
+                        cursor_ += 1 + length;
+                    } else {
+                        return fail(ErrorCode::InvalidEscape);
+                    }
+                } else if (source_[cursor_] == '"') {
+                    cursor_++;
+                    return emitString(scratch_, isKey);
+                } else {
+                    start = cursor_;
+                    if (!skipStringChars()) {
+                        return false;
+                    }
+                    scratch_.append(source_.substr(start, cursor_ - start));
+                }
+            }
+            return fail(ErrorCode::UnterminatedString);
+        }
+
+        // Parses a scalar or enters a container and sets the next step accordingly
+        bool parseValue(Step& step)
+        {
+            skipWhitespace();
+            if (cursor_ >= source_.size()) {
+                return fail(ErrorCode::ExpectedValue);
+            }
+
+            const auto c = source_[cursor_];
+            if (c == '{' || c == '[') {
+                if (levels_.size() >= maxDepth_) {
+                    return fail(ErrorCode::MaxDepthExceeded);
+                }
+                cursor_++;
+                const auto isObject = c == '{';
+                if (!(isObject ? handler_.onStartObject() : handler_.onStartArray())) {
+                    return stopped();
+                }
+                levels_.push_back(Level { isObject, 0 });
+                count([&](ParseStats& stats) {
+                    (isObject ? stats.objects : stats.arrays)++;
+                    stats.maxDepth = std::max(stats.maxDepth, levels_.size());
+                });
+                step = isObject ? Step::ObjectFirst : Step::ArrayFirst;
+                return true;
+            }
+
+            step = Step::AfterValue;
+            if (c == '"') {
+                return parseString(false);
+            }
+            return parseLiteral();
+        }
+
+        // Parses the key and the colon of an object member
+        bool parseKey()
+        {
+            if (source_[cursor_] != '"') {
+                return fail(ErrorCode::ExpectedKey);
+            }
+
+            if (!parseString(true)) {
+                return false;
+            }
+
+            skipWhitespace();
+
+            if (cursor_ >= source_.size() || source_[cursor_] != ':') {
+                return fail(ErrorCode::ExpectedColon);
+            }
+            cursor_++;
+            return true;
+        }
+
+        bool matchLiteral(std::string_view literal)
+        {
+            // The literal has to end here, so e.g. "nullx" is an error, like it has always been
+            const auto end = cursor_ + literal.size();
+            return source_.compare(cursor_, literal.size(), literal) == 0
+                && (end >= source_.size() || !isValueChar(source_[end]));
+        }
+
+        // null, bool or number
+        bool parseLiteral()
+        {
+            const auto c = source_[cursor_];
+            if (!isValueChar(c)) {
+                return fail(ErrorCode::ExpectedValue);
+            }
+
+            bool cont = true;
+            if (c == 'n' && matchLiteral("null")) {
+                count([](ParseStats& stats) { stats.nulls++; });
+                cont = handler_.onNull();
+                cursor_ += 4;
+            } else if (c == 't' && matchLiteral("true")) {
+                count([](ParseStats& stats) { stats.bools++; });
+                cont = handler_.onBool(true);
+                cursor_ += 4;
+            } else if (c == 'f' && matchLiteral("false")) {
+                count([](ParseStats& stats) { stats.bools++; });
+                cont = handler_.onBool(false);
+                cursor_ += 5;
+            } else {
+                LexedNumber number;
+                const auto begin = source_.data() + cursor_;
+                const auto end = lexNumber(begin, source_.data() + source_.size(), number);
+                if (!end || (end < source_.data() + source_.size() && isValueChar(*end))) {
+                    const auto isNumber = c == '-' || (c >= '0' && c <= '9');
+                    return fail(isNumber ? ErrorCode::InvalidNumber : ErrorCode::InvalidLiteral);
+                }
+                count([&](ParseStats& stats) {
+                    stats.numbers++;
+                    stats.integers += number.kind != LexedNumber::Kind::Double;
+                });
+                cont = emitNumber(handler_, number);
+                cursor_ += end - begin;
+            }
+            if (!cont) {
+                return stopped();
+            }
+            return true;
+        }
+
+        std::string_view source_;
+        size_t cursor_ = 0;
+        Handler& handler_;
+        size_t maxDepth_;
+        std::vector<Level> levels_;
+        Error error_;
+        // Strings with escapes are decoded into this
+        std::string scratch_;
+        ParseStats* stats_ = nullptr;
+        bool validateUtf8_ = false;
+    };
+
+    inline uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        const auto duration = std::chrono::steady_clock::now() - start;
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+    // parseSax without reporting the stats. They are only collected if `stats` is not null.
+    template <typename Handler>
+    Result<size_t> runSax(std::string_view source, Handler& handler, const ParseOptions& options,
+        ParseStats* stats)
+    {
+        SaxParser<Handler> parser(source, handler, options.maxDepth);
+        parser.setValidateUtf8(options.validateUtf8);
+        [[maybe_unused]] auto start = std::chrono::steady_clock::time_point();
+        if constexpr (statsEnabled) {
+            if (stats) {
+                parser.setStats(*stats);
+                start = std::chrono::steady_clock::now();
+            }
+        }
+
+        const auto ok = parser.parse();
+        if constexpr (statsEnabled) {
+            if (stats) {
+                stats->parseNanoseconds = nanosecondsSince(start);
+                stats->bytes = parser.cursor();
+            }
+        }
+        if (!ok) {
+            return std::move(parser.error());
+        }
+        return parser.cursor();
+    }
+
+    // Calls func(stats) with the stats to collect (or nullptr) and reports them afterwards
+    template <typename Func>
+    auto withStats(const ParseOptions& options, Func&& func)
+    {
+        if constexpr (statsEnabled) {
+            const auto callback = getStatsCallback();
+            if (options.stats || callback) {
+                ParseStats stats;
+                auto res = func(&stats);
+                if (options.stats) {
+                    *options.stats = stats;
+                }
+                if (callback) {
+                    callback(stats);
+                }
+                return res;
+            }
+        }
+        return func(static_cast<ParseStats*>(nullptr));
+    }
+}
+
+// Parses the first value in source and passes it to the handler piece by piece. Returns the
+// position after the value. If the handler stops parsing, the result is an error with the code
+// StoppedByHandler. Of the options only maxDepth, validateUtf8 and stats apply.
+template <typename Handler>
+Result<size_t> parseSax(std::string_view source, Handler& handler, const ParseOptions& options = {})
+{
+    return detail::withStats(options,
+        [&](ParseStats* stats) { return detail::runSax(source, handler, options, stats); });
+}
+
+// A handler that builds a JsonValue. This is what parse uses.
+class DomBuilder {
+public:
+    // The source is only used to check whether strings can be referenced with
+    // ParseOptions::zeroCopyStrings.
+    DomBuilder(std::string_view source,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource(),
+        const ParseOptions& options = {})
+        : source_(source), memRes_(memRes), options_(options)
+    {
+    }
+
+    bool onNull() { return addValue(JsonValue(JsonValue::Null {})); }
+    bool onBool(bool value) { return addValue(JsonValue(value)); }
+    bool onNumber(double value) { return addValue(JsonValue(value)); }
+    bool onInt(int64_t value) { return addValue(JsonValue(JsonValue::Int(value))); }
+    bool onUInt(uint64_t value) { return addValue(JsonValue(JsonValue::UInt(value))); }
+    bool onString(std::string_view str) { return addValue(JsonValue(makeString(str))); }
+    bool onString(JsonValue::String str) { return addValue(JsonValue(std::move(str))); }
+
+    bool onKey(std::string_view key)
+    {
+        assert(!stack_.empty() && stack_.back()->isObject());
+        if (!internKey(key)) {
+            key_ = makeString(key);
+        }
+        return true;
+    }
+    bool onKey(JsonValue::String key)
+    {
+        assert(!stack_.empty() && stack_.back()->isObject());
+        if (!internKey(key.view())) {
+            key_ = std::move(key);
+        }
+        return true;
+    }
+
+    bool onStartArray() { return startContainer<JsonValue::Array>(); }
+    bool onEndArray(size_t) { return endContainer(); }
+    bool onStartObject() { return startContainer<JsonValue::Object>(); }
+    bool onEndObject(size_t) { return endContainer(); }
+
+    // The root value. Only complete after the parse finished successfully.
+    JsonValue& root() { return root_; }
+
+private:
+    JsonValue::String makeString(std::string_view str) const
+    {
+        // std::less, because comparing unrelated pointers with < is unspecified
+        const auto inSource = std::less_equal<const char*>()(source_.data(), str.data())
+            && std::less<const char*>()(str.data(), source_.data() + source_.size());
+        if (options_.zeroCopyStrings && inSource) {
+            return JsonValue::String::ref(str);
+        }
+        return JsonValue::String(str, memRes_);
+    }
+
+    bool internKey(std::string_view key)
+    {
+        if (!options_.keyInterner) {
+            return false;
+        }
+        const auto interned = options_.keyInterner->intern(key);
+        if (interned) {
+            key_ = JsonValue::String::ref(*interned);
+        }
+        return interned.has_value();
+    }
+
+    // Returns where the value ended up or nullptr if it was dropped because of a duplicate key
+    JsonValue* insert(JsonValue value)
+    {
+        if (stack_.empty()) {
+            root_ = std::move(value);
+            return &root_;
+        }
+        auto& parent = stack_.back()->value_;
+        if (auto object = std::get_if<JsonValue::Object>(&parent)) {
+            const auto [it, inserted] = object->emplace(std::move(key_), std::move(value));
+            return inserted ? &it->second : nullptr;
+        }
+        auto& array = std::get<JsonValue::Array>(parent);
+        array.push_back(std::move(value));
+        return &array.back();
+    }
+
+    bool addValue(JsonValue value)
+    {
+        insert(std::move(value));
+        return true;
+    }
+
+    // Containers are inserted into their parent when they start and filled in place. The parent
+    // doesn't change until the container is complete, so the pointer stays valid.
+    template <typename Container>
+    bool startContainer()
+    {
+        auto slot = insert(JsonValue(Container(memRes_)));
+        if (!slot) {
+            // It will be dropped, but it still has to be built somewhere
+            discarded_.emplace_back(Container(memRes_));
+            slot = &discarded_.back();
+        }
+        stack_.push_back(slot);
+        return true;
+    }
+
+    bool endContainer()
+    {
+        if (!discarded_.empty() && stack_.back() == &discarded_.back()) {
+            discarded_.pop_back();
+        }
+        stack_.pop_back();
+        return true;
+    }
+
+    std::string_view source_;
+    std::pmr::memory_resource* memRes_;
+    ParseOptions options_;
+    // The containers that are currently being built
+    std::vector<JsonValue*> stack_;
+    JsonValue::String key_;
+    // Containers for duplicate keys (which are ignored)
+    std::deque<JsonValue> discarded_;
+    JsonValue root_;
+};
+
+namespace detail {
+    // Like DomBuilder, but overwrites an existing value and reuses the containers and strings in
+    // it (see parseInto). Every container on the stack counts how many of its elements or members
+    // have been parsed so far. The ones after that are left over from the previous value and are
+    // removed when the container ends.
+    class ReuseBuilder {
+    public:
+        ReuseBuilder(JsonValue& target, std::string_view source,
+            std::pmr::memory_resource* memRes, const ParseOptions& options)
+            : target_(target), source_(source), memRes_(memRes), options_(options)
+        {
+        }
+
+        bool onNull() { return setValue(JsonValue::Null {}); }
+        bool onBool(bool value) { return setValue(value); }
+        bool onNumber(double value) { return setValue(value); }
+        bool onInt(int64_t value) { return setValue(JsonValue::Int(value)); }
+        bool onUInt(uint64_t value) { return setValue(JsonValue::UInt(value)); }
+
+        bool onString(std::string_view str)
+        {
+            auto& value = nextSlot()->value_;
+            if (auto string = std::get_if<JsonValue::String>(&value)) {
+                assignString(*string, str);
+            } else {
+                JsonValue::String newString({}, memRes_);
+                assignString(newString, str);
+                value = std::move(newString);
+            }
+            return true;
+        }
+
+        bool onKey(std::string_view key)
+        {
+            auto& frame = stack_.back();
+            auto& object = std::get<JsonValue::Object>(frame.value->value_);
+            const auto existing = object.index_.empty()
+                ? object.findLinear(key, frame.count)
+                : object.findHashed(key, JsonValue::Object::hashKey(key));
+            // Duplicate keys are ignored like in parse, so their value is built somewhere else
+            if (existing < frame.count) {
+                next_ = &discarded_.emplace_back();
+                return true;
+            }
+            if (frame.count == object.members_.size()) {
+                object.members_.emplace_back(JsonValue::String({}, memRes_), JsonValue());
+            }
+            auto& member = object.members_[frame.count];
+            const auto interned = options_.keyInterner ? options_.keyInterner->intern(key)
+                                                       : std::nullopt;
+            if (interned) {
+                member.first = JsonValue::String::ref(*interned);
+            } else {
+                assignString(member.first, key);
+            }
+            frame.count++;
+            object.indexLast(frame.count);
+            next_ = &member.second;
+            return true;
+        }
+
+        bool onStartArray()
+        {
+            auto slot = nextSlot();
+            if (!slot->isArray()) {
+                slot->value_ = JsonValue::Array(memRes_);
+            }
+            stack_.push_back(Frame { slot, 0 });
+            return true;
+        }
+
+        bool onEndArray(size_t)
+        {
+            auto& array = std::get<JsonValue::Array>(stack_.back().value->value_);
+            array.erase(array.begin() + static_cast<ptrdiff_t>(stack_.back().count), array.end());
+            return endContainer();
+        }
+
+        bool onStartObject()
+        {
+            auto slot = nextSlot();
+            if (auto object = std::get_if<JsonValue::Object>(&slot->value_)) {
+                object->index_.clear();
+            } else {
+                slot->value_ = JsonValue::Object(memRes_);
+            }
+            stack_.push_back(Frame { slot, 0 });
+            return true;
+        }
+
+        bool onEndObject(size_t)
+        {
+            auto& object = std::get<JsonValue::Object>(stack_.back().value->value_);
+            auto& members = object.members_;
+            members.erase(members.begin() + static_cast<ptrdiff_t>(stack_.back().count),
+                members.end());
+            return endContainer();
+        }
+
+    private:
+        struct Frame {
+            JsonValue* value;
+            size_t count;
+        };
+
+        void assignString(JsonValue::String& string, std::string_view str) const
+        {
+            // std::less, because comparing unrelated pointers with < is unspecified
+            const auto inSource = std::less_equal<const char*>()(source_.data(), str.data())
+                && std::less<const char*>()(str.data(), source_.data() + source_.size());
+            if (options_.zeroCopyStrings && inSource) {
+                string = JsonValue::String::ref(str);
+            } else {
+                string.assign(str, memRes_);
+            }
+        }
+
+        // Where the next value goes
+        JsonValue* nextSlot()
+        {
+            if (stack_.empty()) {
+                return &target_;
+            }
+            auto& frame = stack_.back();
+            if (frame.value->isObject()) {
+                return next_;
+            }
+            auto& array = std::get<JsonValue::Array>(frame.value->value_);
+            if (frame.count == array.size()) {
+                array.emplace_back();
+            }
+            return &array[frame.count++];
+        }
+
+        template <typename T>
+        bool setValue(T value)
+        {
+            nextSlot()->value_ = value;
+            return true;
+        }
+
+        bool endContainer()
+        {
+            if (!discarded_.empty() && stack_.back().value == &discarded_.back()) {
+                discarded_.pop_back();
+            }
+            stack_.pop_back();
+            return true;
+        }
+
+        JsonValue& target_;
+        std::string_view source_;
+        std::pmr::memory_resource* memRes_;
+        const ParseOptions& options_;
+        std::vector<Frame> stack_;
+        // The value of the last key
+        JsonValue* next_ = nullptr;
+        // Values of duplicate keys
+        std::deque<JsonValue> discarded_;
+    };
+}
+}
@@ -0,0 +1,567 @@
+#include "minijson_scan.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define MINIJSON_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MINIJSON_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace minijson::detail;
+
+namespace {
+template <typename Pred>
+size_t findScalar(const char* data, size_t size, size_t pos, Pred pred)
+{
+    while (pos < size && !pred(data[pos])) {
+        pos++;
+    }
+    return pos;
+}
+
+size_t findStringSpecialScalar(const char* data, size_t size, size_t pos)
+{
+    return findScalar(data, size, pos, isStringSpecial);
+}
+
+size_t findNonWhitespaceScalar(const char* data, size_t size, size_t pos)
+{
+    return findScalar(data, size, pos, [](char ch) { return !isWhitespace(ch); });
+}
+
+size_t findNonValueCharScalar(const char* data, size_t size, size_t pos)
+{
+    return findScalar(data, size, pos, [](char ch) { return !isValueChar(ch); });
+}
+
+size_t findBracketOrQuoteScalar(const char* data, size_t size, size_t pos)
+{
+    return findScalar(data, size, pos, isBracketOrQuote);
+}
+
+size_t findNonAsciiScalar(const char* data, size_t size, size_t pos)
+{
+    return findScalar(
+        data, size, pos, [](char ch) { return static_cast<unsigned char>(ch) >= 0x80; });
+}
+
+#if defined(MINIJSON_X86)
+// SSE2 is part of x86-64, so it doesn't need a target attribute
+__m128i stringSpecialMask(__m128i block)
+{
+    const auto quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+    const auto backslash = _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'));
+    // unsigned block <= 0x1f
+    const auto control = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(0x1f)), block);
+    return _mm_or_si128(_mm_or_si128(quote, backslash), control);
+}
+
+__m128i whitespaceMask(__m128i block)
+{
+    const auto space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+    const auto tab = _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'));
+    const auto lf = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+    const auto cr = _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'));
+    return _mm_or_si128(_mm_or_si128(space, tab), _mm_or_si128(lf, cr));
+}
+
+// Signed compares are fine, because all of the characters are ASCII and everything >= 0x80 is
+// negative.
+__m128i inRange(__m128i block, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(lo - 1))),
+        _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+__m128i valueCharMask(__m128i block)
+{
+    const auto digit = inRange(block, '0', '9');
+    const auto lower = inRange(block, 'a', 'z');
+    const auto upper = inRange(block, 'A', 'Z');
+    const auto dot = _mm_cmpeq_epi8(block, _mm_set1_epi8('.'));
+    const auto plus = _mm_cmpeq_epi8(block, _mm_set1_epi8('+'));
+    const auto minus = _mm_cmpeq_epi8(block, _mm_set1_epi8('-'));
+    return _mm_or_si128(_mm_or_si128(_mm_or_si128(digit, lower), _mm_or_si128(upper, dot)),
+        _mm_or_si128(plus, minus));
+}
+
+// '[' | 0x20 == '{' and ']' | 0x20 == '}', and no other characters map to those
+__m128i bracketOrQuoteMask(__m128i block)
+{
+    const auto quote = _mm_cmpeq_epi8(block, _mm_set1_epi8('"'));
+    const auto folded = _mm_or_si128(block, _mm_set1_epi8(0x20));
+    const auto open = _mm_cmpeq_epi8(folded, _mm_set1_epi8('{'));
+    const auto close = _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'));
+    return _mm_or_si128(quote, _mm_or_si128(open, close));
+}
+
+// movemask only looks at the top bit anyway
+__m128i nonAsciiMask(__m128i block)
+{
+    return block;
+}
+
+// `Invert` finds the first character *not* matching the mask.
+// The last partial block is copied into a buffer padded with `Pad`, which has to end the search.
+// This way we never read past the end of the input and don't need a scalar loop for the rest.
+template <bool Invert, char Pad, typename MaskFunc>
+size_t findSse2(const char* data, size_t size, size_t pos, MaskFunc maskFunc)
+{
+    const auto find = [&](const char* block) {
+        const auto vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(maskFunc(vec)));
+        return Invert ? ~mask & 0xffff : mask;
+    };
+
+    while (pos + 16 <= size) {
+        if (const auto mask = find(data + pos)) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 16;
+    }
+    if (pos < size) {
+        char tail[16];
+        std::memset(tail, Pad, sizeof(tail));
+        std::memcpy(tail, data + pos, size - pos);
+        return std::min<size_t>(pos + __builtin_ctz(find(tail)), size);
+    }
+    return pos;
+}
+
+size_t findStringSpecialSse2(const char* data, size_t size, size_t pos)
+{
+    return findSse2<false, '"'>(data, size, pos, stringSpecialMask);
+}
+
+size_t findNonWhitespaceSse2(const char* data, size_t size, size_t pos)
+{
+    return findSse2<true, 'x'>(data, size, pos, whitespaceMask);
+}
+
+size_t findNonValueCharSse2(const char* data, size_t size, size_t pos)
+{
+    return findSse2<true, ' '>(data, size, pos, valueCharMask);
+}
+
+size_t findBracketOrQuoteSse2(const char* data, size_t size, size_t pos)
+{
+    return findSse2<false, '"'>(data, size, pos, bracketOrQuoteMask);
+}
+
+size_t findNonAsciiSse2(const char* data, size_t size, size_t pos)
+{
+    return findSse2<false, '\x80'>(data, size, pos, nonAsciiMask);
+}
+
+#define MINIJSON_AVX2 __attribute__((target("avx2")))
+
+MINIJSON_AVX2 __m256i stringSpecialMask(__m256i block)
+{
+    const auto quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+    const auto backslash = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\\'));
+    const auto control
+        = _mm256_cmpeq_epi8(_mm256_min_epu8(block, _mm256_set1_epi8(0x1f)), block);
+    return _mm256_or_si256(_mm256_or_si256(quote, backslash), control);
+}
+
+MINIJSON_AVX2 __m256i whitespaceMask(__m256i block)
+{
+    const auto space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+    const auto tab = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'));
+    const auto lf = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'));
+    const auto cr = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r'));
+    return _mm256_or_si256(_mm256_or_si256(space, tab), _mm256_or_si256(lf, cr));
+}
+
+MINIJSON_AVX2 __m256i inRange(__m256i block, char lo, char hi)
+{
+    return _mm256_and_si256(
+        _mm256_cmpgt_epi8(block, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), block));
+}
+
+MINIJSON_AVX2 __m256i valueCharMask(__m256i block)
+{
+    const auto digit = inRange(block, '0', '9');
+    const auto lower = inRange(block, 'a', 'z');
+    const auto upper = inRange(block, 'A', 'Z');
+    const auto dot = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('.'));
+    const auto plus = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('+'));
+    const auto minus = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('-'));
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(digit, lower), _mm256_or_si256(upper, dot)),
+        _mm256_or_si256(plus, minus));
+}
+
+MINIJSON_AVX2 __m256i bracketOrQuoteMask(__m256i block)
+{
+    const auto quote = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('"'));
+    const auto folded = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+    const auto open = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{'));
+    const auto close = _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'));
+    return _mm256_or_si256(quote, _mm256_or_si256(open, close));
+}
+
+enum class Mask { StringSpecial, Whitespace, ValueChar, BracketOrQuote, NonAscii };
+
+// Passing the mask functions (or lambdas) as arguments like for SSE2 would mean passing __m256i
+// through functions without the AVX2 target, which changes the ABI.
+template <Mask M>
+MINIJSON_AVX2 __m256i getMask(__m256i block)
+{
+    if constexpr (M == Mask::StringSpecial) {
+        return stringSpecialMask(block);
+    } else if constexpr (M == Mask::Whitespace) {
+        return whitespaceMask(block);
+    } else if constexpr (M == Mask::BracketOrQuote) {
+        return bracketOrQuoteMask(block);
+    } else if constexpr (M == Mask::NonAscii) {
+        return block;
+    } else {
+        return valueCharMask(block);
+    }
+}
+
+template <bool Invert, Mask M>
+MINIJSON_AVX2 uint32_t findMaskAvx2(const char* block)
+{
+    const auto vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(getMask<M>(vec)));
+    return Invert ? ~mask : mask;
+}
+
+// Same as findSse2. Don't ever call SSE2 code from here (e.g. for the remainder), because the
+// transition from AVX to legacy SSE instructions can be very expensive.
+template <bool Invert, char Pad, Mask M>
+MINIJSON_AVX2 size_t findAvx2(const char* data, size_t size, size_t pos)
+{
+    while (pos + 32 <= size) {
+        if (const auto mask = findMaskAvx2<Invert, M>(data + pos)) {
+            return pos + __builtin_ctz(mask);
+        }
+        pos += 32;
+    }
+    if (pos < size) {
+        char tail[32];
+        std::memset(tail, Pad, sizeof(tail));
+        std::memcpy(tail, data + pos, size - pos);
+        return std::min<size_t>(pos + __builtin_ctz(findMaskAvx2<Invert, M>(tail)), size);
+    }
+    return pos;
+}
+
+MINIJSON_AVX2 size_t findStringSpecialAvx2(const char* data, size_t size, size_t pos)
+{
+    return findAvx2<false, '"', Mask::StringSpecial>(data, size, pos);
+}
+
+MINIJSON_AVX2 size_t findNonWhitespaceAvx2(const char* data, size_t size, size_t pos)
+{
+    return findAvx2<true, 'x', Mask::Whitespace>(data, size, pos);
+}
+
+MINIJSON_AVX2 size_t findNonValueCharAvx2(const char* data, size_t size, size_t pos)
+{
+    return findAvx2<true, ' ', Mask::ValueChar>(data, size, pos);
+}
+
+MINIJSON_AVX2 size_t findBracketOrQuoteAvx2(const char* data, size_t size, size_t pos)
+{
+    return findAvx2<false, '"', Mask::BracketOrQuote>(data, size, pos);
+}
+
+MINIJSON_AVX2 size_t findNonAsciiAvx2(const char* data, size_t size, size_t pos)
+{
+    return findAvx2<false, '\x80', Mask::NonAscii>(data, size, pos);
+}
+#endif
+
+#if defined(MINIJSON_NEON)
+uint8x16_t stringSpecialMask(uint8x16_t block)
+{
+    const auto quote = vceqq_u8(block, vdupq_n_u8('"'));
+    const auto backslash = vceqq_u8(block, vdupq_n_u8('\\'));
+    const auto control = vcltq_u8(block, vdupq_n_u8(0x20));
+    return vorrq_u8(vorrq_u8(quote, backslash), control);
+}
+
+uint8x16_t whitespaceMask(uint8x16_t block)
+{
+    const auto space = vceqq_u8(block, vdupq_n_u8(' '));
+    const auto tab = vceqq_u8(block, vdupq_n_u8('\t'));
+    const auto lf = vceqq_u8(block, vdupq_n_u8('\n'));
+    const auto cr = vceqq_u8(block, vdupq_n_u8('\r'));
+    return vorrq_u8(vorrq_u8(space, tab), vorrq_u8(lf, cr));
+}
+
+uint8x16_t inRange(uint8x16_t block, uint8_t lo, uint8_t hi)
+{
+    return vandq_u8(vcgeq_u8(block, vdupq_n_u8(lo)), vcleq_u8(block, vdupq_n_u8(hi)));
+}
+
+uint8x16_t valueCharMask(uint8x16_t block)
+{
+    const auto digit = inRange(block, '0', '9');
+    const auto lower = inRange(block, 'a', 'z');
+    const auto upper = inRange(block, 'A', 'Z');
+    const auto dot = vceqq_u8(block, vdupq_n_u8('.'));
+    const auto plus = vceqq_u8(block, vdupq_n_u8('+'));
+    const auto minus = vceqq_u8(block, vdupq_n_u8('-'));
+    return vorrq_u8(
+        vorrq_u8(vorrq_u8(digit, lower), vorrq_u8(upper, dot)), vorrq_u8(plus, minus));
+}
+
+uint8x16_t bracketOrQuoteMask(uint8x16_t block)
+{
+    const auto quote = vceqq_u8(block, vdupq_n_u8('"'));
+    const auto folded = vorrq_u8(block, vdupq_n_u8(0x20));
+    const auto open = vceqq_u8(folded, vdupq_n_u8('{'));
+    const auto close = vceqq_u8(folded, vdupq_n_u8('}'));
+    return vorrq_u8(quote, vorrq_u8(open, close));
+}
+
+uint8x16_t nonAsciiMask(uint8x16_t block)
+{
+    return vcgeq_u8(block, vdupq_n_u8(0x80));
+}
+
+// There is no movemask on NEON, so we narrow every byte of the mask to 4 bits instead
+uint64_t toBitmask(uint8x16_t mask)
+{
+    const auto narrowed = vshrn_n_u16(vreinterpretq_u16_u8(mask), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+// Same as findSse2
+template <bool Invert, char Pad, typename MaskFunc>
+size_t findNeon(const char* data, size_t size, size_t pos, MaskFunc maskFunc)
+{
+    const auto find = [&](const char* block) {
+        const auto vec = vld1q_u8(reinterpret_cast<const uint8_t*>(block));
+        const auto mask = toBitmask(maskFunc(vec));
+        return Invert ? ~mask : mask;
+    };
+
+    while (pos + 16 <= size) {
+        if (const auto mask = find(data + pos)) {
+            return pos + __builtin_ctzll(mask) / 4;
+        }
+        pos += 16;
+    }
+    if (pos < size) {
+        char tail[16];
+        std::memset(tail, Pad, sizeof(tail));
+        std::memcpy(tail, data + pos, size - pos);
+        return std::min<size_t>(pos + __builtin_ctzll(find(tail)) / 4, size);
+    }
+    return pos;
+}
+
+size_t findStringSpecialNeon(const char* data, size_t size, size_t pos)
+{
+    return findNeon<false, '"'>(data, size, pos, stringSpecialMask);
+}
+
+size_t findNonWhitespaceNeon(const char* data, size_t size, size_t pos)
+{
+    return findNeon<true, 'x'>(data, size, pos, whitespaceMask);
+}
+
+size_t findNonValueCharNeon(const char* data, size_t size, size_t pos)
+{
+    return findNeon<true, ' '>(data, size, pos, valueCharMask);
+}
+
+size_t findBracketOrQuoteNeon(const char* data, size_t size, size_t pos)
+{
+    return findNeon<false, '"'>(data, size, pos, bracketOrQuoteMask);
+}
+
+size_t findNonAsciiNeon(const char* data, size_t size, size_t pos)
+{
+    return findNeon<false, '\x80'>(data, size, pos, nonAsciiMask);
+}
+#endif
+
+using FindFunc = size_t (*)(const char*, size_t, size_t);
+
+size_t resolveFindStringSpecial(const char* data, size_t size, size_t pos);
+size_t resolveFindNonWhitespace(const char* data, size_t size, size_t pos);
+size_t resolveFindNonValueChar(const char* data, size_t size, size_t pos);
+size_t resolveFindBracketOrQuote(const char* data, size_t size, size_t pos);
+size_t resolveFindNonAscii(const char* data, size_t size, size_t pos);
+
+// These start out as resolvers, which pick the implementation on the first call. This way we
+// don't depend on the static initialization order if someone parses during static init.
+// They are atomic, because the first calls might come from multiple threads at once.
+std::atomic<FindFunc> findStringSpecialImpl { resolveFindStringSpecial };
+std::atomic<FindFunc> findNonWhitespaceImpl { resolveFindNonWhitespace };
+std::atomic<FindFunc> findNonValueCharImpl { resolveFindNonValueChar };
+std::atomic<FindFunc> findBracketOrQuoteImpl { resolveFindBracketOrQuote };
+std::atomic<FindFunc> findNonAsciiImpl { resolveFindNonAscii };
+std::atomic<SimdLevel> currentLevel { SimdLevel::Scalar };
+
+bool isSupported(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Scalar:
+        return true;
+#if defined(MINIJSON_X86)
+    case SimdLevel::Sse2:
+        return true;
+    case SimdLevel::Avx2:
+        return getSupportedSimdLevel() == SimdLevel::Avx2;
+#endif
+#if defined(MINIJSON_NEON)
+    case SimdLevel::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+void use(SimdLevel level)
+{
+    FindFunc stringSpecial = findStringSpecialScalar;
+    FindFunc nonWhitespace = findNonWhitespaceScalar;
+    FindFunc nonValueChar = findNonValueCharScalar;
+    FindFunc bracketOrQuote = findBracketOrQuoteScalar;
+    FindFunc nonAscii = findNonAsciiScalar;
+    switch (level) {
+#if defined(MINIJSON_X86)
+    case SimdLevel::Sse2:
+        stringSpecial = findStringSpecialSse2;
+        nonWhitespace = findNonWhitespaceSse2;
+        nonValueChar = findNonValueCharSse2;
+        bracketOrQuote = findBracketOrQuoteSse2;
+        nonAscii = findNonAsciiSse2;
+        break;
+    case SimdLevel::Avx2:
+        stringSpecial = findStringSpecialAvx2;
+        nonWhitespace = findNonWhitespaceAvx2;
+        nonValueChar = findNonValueCharAvx2;
+        bracketOrQuote = findBracketOrQuoteAvx2;
+        nonAscii = findNonAsciiAvx2;
+        break;
+#endif
+#if defined(MINIJSON_NEON)
+    case SimdLevel::Neon:
+        stringSpecial = findStringSpecialNeon;
+        nonWhitespace = findNonWhitespaceNeon;
+        nonValueChar = findNonValueCharNeon;
+        bracketOrQuote = findBracketOrQuoteNeon;
+        nonAscii = findNonAsciiNeon;
+        break;
+#endif
+    default:
+        break;
+    }
+    currentLevel.store(level, std::memory_order_relaxed);
+    findStringSpecialImpl.store(stringSpecial, std::memory_order_relaxed);
+    findNonWhitespaceImpl.store(nonWhitespace, std::memory_order_relaxed);
+    findNonValueCharImpl.store(nonValueChar, std::memory_order_relaxed);
+    findBracketOrQuoteImpl.store(bracketOrQuote, std::memory_order_relaxed);
+    findNonAsciiImpl.store(nonAscii, std::memory_order_relaxed);
+}
+
+void resolve()
+{
+    use(getSupportedSimdLevel());
+}
+
+size_t resolveFindStringSpecial(const char* data, size_t size, size_t pos)
+{
+    resolve();
+    return findStringSpecial(data, size, pos);
+}
+
+size_t resolveFindNonWhitespace(const char* data, size_t size, size_t pos)
+{
+    resolve();
+    return findNonWhitespace(data, size, pos);
+}
+
+size_t resolveFindNonValueChar(const char* data, size_t size, size_t pos)
+{
+    resolve();
+    return findNonValueChar(data, size, pos);
+}
+
+size_t resolveFindBracketOrQuote(const char* data, size_t size, size_t pos)
+{
+    resolve();
+    return findBracketOrQuote(data, size, pos);
+}
+
+size_t resolveFindNonAscii(const char* data, size_t size, size_t pos)
+{
+    resolve();
+    return findNonAscii(data, size, pos);
+}
+}
+
+namespace minijson::detail {
+SimdLevel getSupportedSimdLevel()
+{
+#if defined(MINIJSON_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::Avx2;
+    }
+    return SimdLevel::Sse2;
+#elif defined(MINIJSON_NEON)
+    return SimdLevel::Neon;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel getSimdLevel()
+{
+    if (findStringSpecialImpl.load(std::memory_order_relaxed) == resolveFindStringSpecial) {
+        resolve();
+    }
+    return currentLevel.load(std::memory_order_relaxed);
+}
+
+bool setSimdLevel(SimdLevel level)
+{
+    if (!isSupported(level)) {
+        return false;
+    }
+    use(level);
+    return true;
+}
+
+size_t findStringSpecial(const char* data, size_t size, size_t pos)
+{
+    return findStringSpecialImpl.load(std::memory_order_relaxed)(data, size, pos);
+}
+
+size_t findNonWhitespace(const char* data, size_t size, size_t pos)
+{
+    return findNonWhitespaceImpl.load(std::memory_order_relaxed)(data, size, pos);
+}
+
+size_t findNonValueChar(const char* data, size_t size, size_t pos)
+{
+    return findNonValueCharImpl.load(std::memory_order_relaxed)(data, size, pos);
+}
+
+size_t findBracketOrQuote(const char* data, size_t size, size_t pos)
+{
+    return findBracketOrQuoteImpl.load(std::memory_order_relaxed)(data, size, pos);
+}
+
+size_t findNonAscii(const char* data, size_t size, size_t pos)
+{
+    return findNonAsciiImpl.load(std::memory_order_relaxed)(data, size, pos);
+}
+}
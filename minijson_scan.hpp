@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+// Block scanners used by the parser. They are picked at runtime depending on what the CPU
+// supports. All of them return the position of the first matching character at or after `pos`
+// or `size` if there is none.
+
+namespace minijson::detail {
+enum class SimdLevel {
+    Scalar = 0,
+    Sse2,
+    Avx2,
+    Neon,
+};
+
+// The best level supported by this CPU
+SimdLevel getSupportedSimdLevel();
+SimdLevel getSimdLevel();
+// Mostly useful for testing and benchmarking. Returns false if the CPU does not support `level`.
+bool setSimdLevel(SimdLevel level);
+
+// '"', '\\' or a control character (< 0x20)
+size_t findStringSpecial(const char* data, size_t size, size_t pos);
+
+// Anything but ' ', '\t', '\n' and '\r'
+size_t findNonWhitespace(const char* data, size_t size, size_t pos);
+
+// Anything that can not be part of a literal or a number (i.e. not [0-9a-zA-Z.+-])
+size_t findNonValueChar(const char* data, size_t size, size_t pos);
+
+// '"', '[', ']', '{' or '}'
+size_t findBracketOrQuote(const char* data, size_t size, size_t pos);
+
+// Anything >= 0x80
+size_t findNonAscii(const char* data, size_t size, size_t pos);
+
+inline bool isWhitespace(char ch)
+{
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+inline bool isStringSpecial(char ch)
+{
+    return ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20;
+}
+
+inline bool isValueChar(char ch)
+{
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')
+        || ch == '.' || ch == '+' || ch == '-';
+}
+
+inline bool isBracketOrQuote(char ch)
+{
+    return ch == '"' || ch == '[' || ch == ']' || ch == '{' || ch == '}';
+}
+}
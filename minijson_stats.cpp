@@ -0,0 +1,21 @@
+#include "minijson_stats.hpp"
+
+#include <atomic>
+
+namespace {
+std::atomic<minijson::StatsCallback> statsCallback { nullptr };
+}
+
+namespace minijson {
+void setStatsCallback(StatsCallback callback)
+{
+    statsCallback.store(callback, std::memory_order_release);
+}
+
+namespace detail {
+    StatsCallback getStatsCallback()
+    {
+        return statsCallback.load(std::memory_order_acquire);
+    }
+}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// Statistics about parses. They are only collected if the library (and everything that includes
+// its headers) is built with MINIJSON_ENABLE_STATS (the CMake option MINIJSON_STATS or the meson
+// option stats). Otherwise none of this costs anything.
+namespace minijson {
+struct ParseStats {
+    // Of the source, up to the end of the value
+    size_t bytes = 0;
+    size_t nulls = 0;
+    size_t bools = 0;
+    // Including the integers
+    size_t numbers = 0;
+    size_t integers = 0;
+    size_t strings = 0;
+    size_t keys = 0;
+    // Strings and keys that contain escapes, which have to be decoded
+    size_t escapedStrings = 0;
+    size_t arrays = 0;
+    size_t objects = 0;
+    size_t maxDepth = 0;
+    // Only counted if the values are allocated from a CountingResource
+    size_t allocations = 0;
+    size_t allocatedBytes = 0;
+    // Parsing, including whatever the handler does (e.g. building the JsonValue)
+    uint64_t parseNanoseconds = 0;
+};
+
+// Called after every parse, parseTape and parseSax on the thread that parsed, so it has to be
+// thread-safe if there is more than one. The ParseStats are only valid during the call.
+using StatsCallback = void (*)(const ParseStats& stats);
+// nullptr removes the callback
+void setStatsCallback(StatsCallback callback);
+
+// Counts allocations and passes them on to upstream. Not thread-safe.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : upstream_(upstream)
+    {
+    }
+
+    size_t allocations() const { return allocations_; }
+    size_t allocatedBytes() const { return allocatedBytes_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocations_++;
+        allocatedBytes_ += bytes;
+        return upstream_->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        upstream_->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream_;
+    size_t allocations_ = 0;
+    size_t allocatedBytes_ = 0;
+};
+
+namespace detail {
+#ifdef MINIJSON_ENABLE_STATS
+    constexpr bool statsEnabled = true;
+#else
+    constexpr bool statsEnabled = false;
+#endif
+
+    StatsCallback getStatsCallback();
+}
+}
@@ -0,0 +1,347 @@
+#include "minijson_stream.hpp"
+
+#include <cassert>
+
+#include "minijson_scan.hpp"
+#include "minijson_unicode.hpp"
+
+namespace minijson {
+StreamParser::StreamParser(std::pmr::memory_resource* memRes, const ParseOptions& options)
+    : memRes_(memRes), options_(options), builder_({}, memRes, options_), string_(memRes)
+{
+}
+
+StreamParser::StreamParser(const ParseOptions& options, std::pmr::memory_resource* memRes)
+    : StreamParser(memRes, options)
+{
+}
+
+void StreamParser::reset()
+{
+    state_ = State::Value;
+    levels_.clear();
+    builder_ = DomBuilder({}, memRes_, options_);
+    string_.clear();
+    literal_.clear();
+    error_ = Error {};
+    offset_ = 0;
+}
+
+bool StreamParser::fail(size_t cursor, ErrorCode code)
+{
+    error_ = Error { code, offset_ + cursor };
+    return false;
+}
+
+// Like parse, at the 'u' of the escape
+bool StreamParser::failUnicode()
+{
+    error_ = Error { ErrorCode::InvalidUnicodeEscape, unicodeStart_ };
+    return false;
+}
+
+bool StreamParser::feed(std::string_view chunk)
+{
+    if (failed()) {
+        return false;
+    }
+    size_t cursor = 0;
+    while (cursor < chunk.size()) {
+        if (!step(chunk, cursor)) {
+            return false;
+        }
+    }
+    offset_ += chunk.size();
+    return true;
+}
+
+bool StreamParser::step(std::string_view chunk, size_t& cursor)
+{
+    if (state_ == State::String) {
+        const auto end = detail::findStringSpecial(chunk.data(), chunk.size(), cursor);
+        string_.append(chunk.substr(cursor, end - cursor));
+        cursor = end;
+        if (cursor >= chunk.size()) {
+            return true;
+        }
+        const auto c = chunk[cursor];
+        cursor++;
+        if (c == '"') {
+            completeString();
+        } else if (c == '\\') {
+            state_ = State::StringEscape;
+        } else {
+            // We accept control characters, just like parse
+            string_.push_back(c);
+        }
+        return true;
+    }
+
+    if (state_ == State::StringEscape) {
+        const auto c = chunk[cursor];
+        if (const auto decoded = detail::escapeTable[static_cast<unsigned char>(c)]) {
+            string_.push_back(decoded);
+            state_ = State::String;
+        } else if (c == 'u') {
+            unicode_.clear();
+            unicodeStart_ = offset_ + cursor;
+            state_ = State::StringUnicode;
+        } else {
+            return fail(cursor, ErrorCode::InvalidEscape);
+        }
+        cursor++;
+        return true;
+    }
+
+    // Collects the escape after the 'u' (and the second half of a surrogate pair) one character
+    // at a time, because it might be split across chunks
+    if (state_ == State::StringUnicode) {
+        const auto c = chunk[cursor];
+        const auto size = unicode_.size();
+        if ((size < 4 || size >= 6) && detail::hexTable[static_cast<unsigned char>(c)] < 0) {
+            return failUnicode();
+        }
+        if ((size == 4 && c != '\\') || (size == 5 && c != 'u')) {
+            return failUnicode();
+        }
+        unicode_.push_back(c);
+        cursor++;
+        const auto first = unicode_.size() >= 4 ? detail::decodeHex4(unicode_.data()) : -1;
+        const auto isHighSurrogate = first >= 0xd800 && first <= 0xdbff;
+        if (unicode_.size() == 10 || (unicode_.size() == 4 && !isHighSurrogate)) {
+            uint32_t codePoint;
+            const auto begin = unicode_.data();
+            if (!detail::decodeUnicodeEscape(begin, begin + unicode_.size(), codePoint)) {
+                return failUnicode();
+            }
+            detail::appendUtf8(string_, codePoint);
+            state_ = State::String;
+        }
+        return true;
+    }
+
+    if (state_ == State::Literal) {
+        const auto end = detail::findNonValueChar(chunk.data(), chunk.size(), cursor);
+        literal_.append(chunk.substr(cursor, end - cursor));
+        cursor = end;
+        // If the literal reaches the end of the chunk, it might continue in the next one
+        if (cursor < chunk.size()) {
+            return completeLiteral();
+        }
+        return true;
+    }
+
+    if (detail::isWhitespace(chunk[cursor])) {
+        cursor = detail::findNonWhitespace(chunk.data(), chunk.size(), cursor + 1);
+        if (cursor >= chunk.size()) {
+            return true;
+        }
+    }
+
+    const auto c = chunk[cursor];
+    switch (state_) {
+    case State::ArrayValueOrEnd:
+        if (c == ']') {
+            cursor++;
+            popLevel();
+            return true;
+        }
+        [[fallthrough]];
+    case State::ArrayValue:
+        if (c == ']') {
+            return fail(cursor, ErrorCode::TrailingComma);
+        }
+        [[fallthrough]];
+    case State::Value:
+        if (c == '{' || c == '[') {
+            // Destroying the result is recursive, so the depth is limited like with parse
+            if (levels_.size() >= options_.maxDepth) {
+                return fail(cursor, ErrorCode::MaxDepthExceeded);
+            }
+            cursor++;
+            pushLevel(c == '{');
+        } else if (c == '"') {
+            cursor++;
+            stringIsKey_ = false;
+            state_ = State::String;
+        } else if (detail::isValueChar(c)) {
+            literal_.clear();
+            literalStart_ = offset_ + cursor;
+            state_ = State::Literal;
+        } else {
+            return fail(cursor, ErrorCode::ExpectedValue);
+        }
+        return true;
+    case State::ArrayNext:
+        if (c == ',') {
+            state_ = State::ArrayValue;
+        } else if (c == ']') {
+            popLevel();
+        } else {
+            return fail(cursor, ErrorCode::ExpectedSeparator);
+        }
+        cursor++;
+        return true;
+    case State::ObjectKeyOrEnd:
+        if (c == '}') {
+            cursor++;
+            popLevel();
+            return true;
+        }
+        [[fallthrough]];
+    case State::ObjectKey:
+        if (c == '}') {
+            return fail(cursor, ErrorCode::TrailingComma);
+        } else if (c != '"') {
+            return fail(cursor, ErrorCode::ExpectedKey);
+        }
+        cursor++;
+        stringIsKey_ = true;
+        state_ = State::String;
+        return true;
+    case State::Colon:
+        if (c != ':') {
+            return fail(cursor, ErrorCode::ExpectedColon);
+        }
+        cursor++;
+        state_ = State::Value;
+        return true;
+    case State::ObjectNext:
+        if (c == ',') {
+            state_ = State::ObjectKey;
+        } else if (c == '}') {
+            popLevel();
+        } else {
+            return fail(cursor, ErrorCode::ExpectedSeparator);
+        }
+        cursor++;
+        return true;
+    case State::Done:
+        // Only whitespace may follow the root, which was skipped above
+        return fail(cursor, ErrorCode::TrailingCharacters);
+    default:
+        assert(false && "Invalid state");
+        return false;
+    }
+}
+
+bool StreamParser::completeLiteral()
+{
+    if (literal_ == "null") {
+        builder_.onNull();
+    } else if (literal_ == "true") {
+        builder_.onBool(true);
+    } else if (literal_ == "false") {
+        builder_.onBool(false);
+    } else {
+        detail::LexedNumber number;
+        const auto end = literal_.data() + literal_.size();
+        if (detail::lexNumber(literal_.data(), end, number) != end) {
+            // Like parse, anything that doesn't start like a number is a misspelled literal
+            const auto c = literal_[0];
+            const auto isNumber = c == '-' || (c >= '0' && c <= '9');
+            error_ = Error { isNumber ? ErrorCode::InvalidNumber : ErrorCode::InvalidLiteral,
+                literalStart_ };
+            return false;
+        }
+        detail::emitNumber(builder_, number);
+    }
+    completeValue();
+    return true;
+}
+
+void StreamParser::completeString()
+{
+    JsonValue::String str(std::move(string_));
+    string_ = std::pmr::string(memRes_);
+    if (stringIsKey_) {
+        builder_.onKey(std::move(str));
+        state_ = State::Colon;
+    } else {
+        builder_.onString(std::move(str));
+        completeValue();
+    }
+}
+
+void StreamParser::completeValue()
+{
+    if (levels_.empty()) {
+        state_ = State::Done;
+        return;
+    }
+
+    auto& level = levels_.back();
+    level.count++;
+    state_ = level.isObject ? State::ObjectNext : State::ArrayNext;
+}
+
+void StreamParser::pushLevel(bool isObject)
+{
+    levels_.push_back(Level { isObject, 0 });
+    if (isObject) {
+        builder_.onStartObject();
+        state_ = State::ObjectKeyOrEnd;
+    } else {
+        builder_.onStartArray();
+        state_ = State::ArrayValueOrEnd;
+    }
+}
+
+void StreamParser::popLevel()
+{
+    const auto level = levels_.back();
+    levels_.pop_back();
+    if (level.isObject) {
+        builder_.onEndObject(level.count);
+    } else {
+        builder_.onEndArray(level.count);
+    }
+    completeValue();
+}
+
+Result<JsonValue> StreamParser::finish()
+{
+    if (!failed() && state_ == State::Literal) {
+        completeLiteral();
+    }
+
+    // The same errors that parse reports at the end of the source
+    switch (failed() ? State::Done : state_) {
+    case State::Done:
+        break;
+    case State::String:
+    case State::StringEscape:
+        fail(0, ErrorCode::UnterminatedString);
+        break;
+    case State::StringUnicode:
+        failUnicode();
+        break;
+    case State::Value:
+        fail(0, ErrorCode::ExpectedValue);
+        break;
+    case State::Colon:
+        fail(0, ErrorCode::ExpectedColon);
+        break;
+    case State::ArrayNext:
+    case State::ObjectNext:
+        fail(0, ErrorCode::ExpectedSeparator);
+        break;
+    case State::ArrayValueOrEnd:
+    case State::ArrayValue:
+        fail(0, ErrorCode::UnterminatedArray);
+        break;
+    default:
+        fail(0, ErrorCode::UnterminatedObject);
+        break;
+    }
+
+    if (failed()) {
+        const auto error = error_;
+        reset();
+        return error;
+    }
+    auto root = std::move(builder_.root());
+    reset();
+    return root;
+}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "minijson.hpp"
+#include "minijson_sax.hpp"
+
+namespace minijson {
+// Parses a document that arrives in chunks (e.g. from a socket or a pipe). Tokens may be split
+// across chunks arbitrarily. Chunks do not have to outlive the call to feed, so strings are always
+// copied (i.e. ParseOptions::zeroCopyStrings does not apply).
+// Like with parse, the stream has to be a single value, which may be surrounded by whitespace.
+// The values are built with the same DomBuilder that parse uses. Of the options only maxDepth and
+// keyInterner apply.
+class StreamParser {
+public:
+    StreamParser(std::pmr::memory_resource* memRes = std::pmr::get_default_resource(),
+        const ParseOptions& options = {});
+    StreamParser(const ParseOptions& options,
+        std::pmr::memory_resource* memRes = std::pmr::get_default_resource());
+
+    // Returns false if the chunk could not be parsed. The error is kept and every subsequent
+    // feed/finish will fail with it.
+    bool feed(std::string_view chunk);
+
+    // Whether the root value is complete
+    bool done() const { return state_ == State::Done; }
+
+    // ErrorCode::None if nothing failed since the last finish
+    const Error& error() const { return error_; }
+
+    // Returns the root value or an error if the document is incomplete.
+    // Resets the parser afterwards, so it can be used for the next document.
+    Result<JsonValue> finish();
+
+private:
+    enum class State {
+        Value,
+        ArrayValueOrEnd,
+        // After a comma
+        ArrayValue,
+        ArrayNext,
+        ObjectKeyOrEnd,
+        ObjectKey,
+        Colon,
+        ObjectNext,
+        String,
+        StringEscape,
+        StringUnicode,
+        Literal,
+        Done,
+    };
+
+    struct Level {
+        bool isObject;
+        size_t count;
+    };
+
+    void reset();
+    // Process as much of the chunk as possible in the current state. Returns false on error.
+    bool step(std::string_view chunk, size_t& cursor);
+    bool fail(size_t cursor, ErrorCode code);
+    bool failUnicode();
+    bool failed() const { return error_.code != ErrorCode::None; }
+    bool completeLiteral();
+    void completeString();
+    void completeValue();
+    void pushLevel(bool isObject);
+    void popLevel();
+
+    std::pmr::memory_resource* memRes_;
+    ParseOptions options_;
+    DomBuilder builder_;
+    State state_ = State::Value;
+    std::vector<Level> levels_;
+    std::pmr::string string_;
+    bool stringIsKey_ = false;
+    // The part of a \u escape after the 'u' that has been seen so far
+    std::string unicode_;
+    size_t unicodeStart_ = 0;
+    std::string literal_;
+    size_t literalStart_ = 0;
+    Error error_;
+    // Total number of bytes fed before the current chunk, so errors refer to the whole stream
+    size_t offset_ = 0;
+};
+}
@@ -0,0 +1,286 @@
+#include "minijson_tape.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "minijson_sax.hpp"
+
+using namespace minijson;
+
+namespace {
+constexpr uint64_t payloadMask = 0x00ff'ffff'ffff'ffff;
+constexpr uint64_t maxCount = detail::tapeMaxCount;
+
+uint64_t makeEntry(TapeTag tag, uint64_t payload = 0)
+{
+    assert(payload <= payloadMask);
+    return (static_cast<uint64_t>(tag) << 56) | payload;
+}
+}
+
+namespace minijson::detail {
+class TapeBuilder {
+public:
+    TapeBuilder(std::string_view source)
+    {
+        // Rough guesses, so we don't have to grow too often
+        tape_.reserve(source.size() / 4 + 4);
+        strings_.reserve(source.size() / 2 + 16);
+    }
+
+    bool onNull() { return push(TapeTag::Null); }
+    bool onBool(bool value) { return push(value ? TapeTag::True : TapeTag::False); }
+
+    bool onNumber(double value) { return pushNumber(TapeTag::Number, value); }
+    bool onInt(int64_t value) { return pushNumber(TapeTag::Int, value); }
+    bool onUInt(uint64_t value) { return pushNumber(TapeTag::UInt, value); }
+
+    bool onString(std::string_view str)
+    {
+        const auto offset = strings_.size();
+        assert(str.size() <= std::numeric_limits<uint32_t>::max());
+        const auto length = static_cast<uint32_t>(str.size());
+        strings_.resize(offset + sizeof(uint32_t) + str.size());
+        std::memcpy(strings_.data() + offset, &length, sizeof(uint32_t));
+        std::memcpy(strings_.data() + offset + sizeof(uint32_t), str.data(), str.size());
+        return push(TapeTag::String, offset);
+    }
+
+    bool onKey(std::string_view key) { return onString(key); }
+
+    // The start entry is patched when the container is closed
+    bool onStartArray() { return startContainer(TapeTag::ArrayStart); }
+    bool onEndArray(size_t count)
+    {
+        return endContainer(TapeTag::ArrayStart, TapeTag::ArrayEnd, count);
+    }
+    bool onStartObject() { return startContainer(TapeTag::ObjectStart); }
+    bool onEndObject(size_t count)
+    {
+        return endContainer(TapeTag::ObjectStart, TapeTag::ObjectEnd, count);
+    }
+
+    Tape finish()
+    {
+        Tape tape;
+        tape.numEntries_ = tape_.size();
+        tape.stringsSize_ = strings_.size();
+        const auto stringEntries = (strings_.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+        tape.data_ = std::make_unique<uint64_t[]>(tape_.size() + stringEntries);
+        std::memcpy(tape.data_.get(), tape_.data(), tape_.size() * sizeof(uint64_t));
+        std::memcpy(tape.data_.get() + tape_.size(), strings_.data(), strings_.size());
+        return tape;
+    }
+
+private:
+    bool push(TapeTag tag, uint64_t payload = 0)
+    {
+        tape_.push_back(makeEntry(tag, payload));
+        return true;
+    }
+
+    template <typename T>
+    bool pushNumber(TapeTag tag, T value)
+    {
+        static_assert(sizeof(T) == sizeof(uint64_t));
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        tape_.push_back(makeEntry(tag));
+        tape_.push_back(bits);
+        return true;
+    }
+
+    bool startContainer(TapeTag tag)
+    {
+        starts_.push_back(tape_.size());
+        return push(tag);
+    }
+
+    bool endContainer(TapeTag startTag, TapeTag endTag, size_t count)
+    {
+        const auto start = starts_.back();
+        starts_.pop_back();
+        push(endTag, start);
+        const auto next = static_cast<uint64_t>(tape_.size());
+        // parseTape rejects sources for which this could overflow
+        assert(next <= std::numeric_limits<uint32_t>::max());
+        tape_[start] = makeEntry(startTag, (std::min<uint64_t>(count, maxCount) << 32) | next);
+        return true;
+    }
+
+    std::vector<uint64_t> tape_;
+    std::vector<char> strings_;
+    // Indices of the start entries of all open containers
+    std::vector<size_t> starts_;
+};
+}
+
+namespace minijson {
+JsonValue::Type ValueRef::type() const
+{
+    if (!isValid()) {
+        return JsonValue::Type::Invalid;
+    }
+    switch (tag()) {
+    case TapeTag::Null:
+        return JsonValue::Type::Null;
+    case TapeTag::True:
+    case TapeTag::False:
+        return JsonValue::Type::Bool;
+    case TapeTag::Number:
+    case TapeTag::Int:
+    case TapeTag::UInt:
+        return JsonValue::Type::Number;
+    case TapeTag::String:
+        return JsonValue::Type::String;
+    case TapeTag::ArrayStart:
+        return JsonValue::Type::Array;
+    case TapeTag::ObjectStart:
+        return JsonValue::Type::Object;
+    default:
+        assert(false && "Invalid tape entry");
+        return JsonValue::Type::Invalid;
+    }
+}
+
+bool ValueRef::asBool() const
+{
+    assert(isBool());
+    return tag() == TapeTag::True;
+}
+
+double ValueRef::asNumber() const
+{
+    assert(isNumber());
+    if (tag() == TapeTag::Int) {
+        return static_cast<double>(asInt());
+    } else if (tag() == TapeTag::UInt) {
+        return static_cast<double>(asUInt());
+    }
+    double number;
+    std::memcpy(&number, &tape_[index_ + 1], sizeof(double));
+    return number;
+}
+
+int64_t ValueRef::asInt() const
+{
+    assert(isInt());
+    return static_cast<int64_t>(tape_[index_ + 1]);
+}
+
+uint64_t ValueRef::asUInt() const
+{
+    assert(isUInt());
+    return tape_[index_ + 1];
+}
+
+std::string_view ValueRef::asString() const
+{
+    assert(isString());
+    const auto str = strings_ + payload();
+    uint32_t length;
+    std::memcpy(&length, str, sizeof(uint32_t));
+    return std::string_view(str + sizeof(uint32_t), length);
+}
+
+ValueRef::ArrayView ValueRef::asArray() const
+{
+    assert(isArray());
+    return ArrayView(*this);
+}
+
+ValueRef::ObjectView ValueRef::asObject() const
+{
+    assert(isObject());
+    return ObjectView(*this);
+}
+
+size_t ValueRef::size() const
+{
+    if (!isValid() || isNull()) {
+        return 0;
+    } else if (isArray() || isObject()) {
+        const auto count = payload() >> 32;
+        if (count < maxCount) {
+            return count;
+        }
+        size_t n = 0;
+        for (auto it = childBegin(isObject()), end = childEnd(isObject()); it != end; ++it) {
+            n++;
+        }
+        return n;
+    } else {
+        return 1;
+    }
+}
+
+size_t ValueRef::next() const
+{
+    switch (tag()) {
+    case TapeTag::Number:
+    case TapeTag::Int:
+    case TapeTag::UInt:
+        return index_ + 2;
+    case TapeTag::ArrayStart:
+    case TapeTag::ObjectStart:
+        return payload() & 0xffff'ffff;
+    default:
+        return index_ + 1;
+    }
+}
+
+ValueRef ValueRef::operator[](std::string_view key) const
+{
+    if (!isObject()) {
+        return ValueRef();
+    }
+    for (auto it = childBegin(true), end = childEnd(true); it != end; ++it) {
+        if (it.key() == key) {
+            return *it;
+        }
+    }
+    return ValueRef();
+}
+
+ValueRef ValueRef::operator[](size_t index) const
+{
+    if (!isArray()) {
+        return ValueRef();
+    }
+    // Skip the walk if we know the index is out of range
+    const auto count = payload() >> 32;
+    if (count < maxCount && index >= count) {
+        return ValueRef();
+    }
+    size_t i = 0;
+    for (auto it = childBegin(false), end = childEnd(false); it != end; ++it) {
+        if (i == index) {
+            return *it;
+        }
+        i++;
+    }
+    return ValueRef();
+}
+
+Result<Tape> parseTape(std::string_view source, const ParseOptions& options)
+{
+    // Every byte of the source adds at most one entry (plus one for a number at the root), so
+    // entry indices and string lengths fit into their 32 bits below this
+    if (source.size() >= std::numeric_limits<uint32_t>::max()) {
+        return Error { ErrorCode::SourceTooLarge, 0 };
+    }
+    detail::TapeBuilder builder(source);
+    const auto res = parseSax(source, builder, options);
+    if (!res) {
+        return res.error();
+    }
+    const auto end = detail::findNonWhitespace(source.data(), source.size(), *res);
+    if (end < source.size()) {
+        return Error { ErrorCode::TrailingCharacters, end };
+    }
+    return builder.finish();
+}
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "minijson.hpp"
+
+namespace minijson {
+// Every value is stored as one tagged 64-bit entry (the tag is in the upper 8 bits) in a single
+// contiguous tape:
+// - Null, True, False: just the tag
+// - Number, Int, UInt: the tag, followed by another entry with the bits of the double, int64_t or
+//   uint64_t respectively (see JsonValue::Int)
+// - String: offset into the string buffer, which holds a uint32_t length followed by the bytes
+// - ArrayStart, ObjectStart: the number of elements in bits 32-55 (saturated at 0xffffff) and
+//   the index of the entry following the matching end in bits 0-31
+// - ArrayEnd, ObjectEnd: the index of the matching start
+// Object members are a String entry for the key followed by the value.
+enum class TapeTag : uint8_t {
+    Null = 'n',
+    True = 't',
+    False = 'f',
+    Number = 'd',
+    Int = 'l',
+    UInt = 'u',
+    String = '"',
+    ArrayStart = '[',
+    ArrayEnd = ']',
+    ObjectStart = '{',
+    ObjectEnd = '}',
+};
+
+namespace detail {
+class TapeBuilder;
+
+// Larger counts of elements are saturated to this
+constexpr uint64_t tapeMaxCount = 0xff'ffff;
+}
+
+// Lightweight view of a value on a tape. It's only valid as long as the Tape is alive.
+class ValueRef {
+public:
+    class Iterator;
+    struct Member;
+    class ArrayView;
+    class ObjectView;
+
+    ValueRef() = default; // invalid
+    ValueRef(const uint64_t* tape, const char* strings, size_t index)
+        : tape_(tape), strings_(strings), index_(index)
+    {
+    }
+
+    JsonValue::Type type() const;
+
+    bool isValid() const { return tape_ != nullptr; }
+    bool isNull() const { return isValid() && tag() == TapeTag::Null; }
+    bool isBool() const { return isValid() && (tag() == TapeTag::True || tag() == TapeTag::False); }
+    bool isNumber() const
+    {
+        return isValid()
+            && (tag() == TapeTag::Number || tag() == TapeTag::Int || tag() == TapeTag::UInt);
+    }
+    bool isInt() const { return isValid() && tag() == TapeTag::Int; }
+    bool isUInt() const { return isValid() && tag() == TapeTag::UInt; }
+    bool isString() const { return isValid() && tag() == TapeTag::String; }
+    bool isArray() const { return isValid() && tag() == TapeTag::ArrayStart; }
+    bool isObject() const { return isValid() && tag() == TapeTag::ObjectStart; }
+
+    // Unlike JsonValue these do not throw, but assert the type
+    bool asBool() const;
+    // Converts Int and UInt, which might lose precision
+    double asNumber() const;
+    int64_t asInt() const;
+    uint64_t asUInt() const;
+    std::string_view asString() const;
+    ArrayView asArray() const;
+    ObjectView asObject() const;
+
+    // 0 for null and invalid, number of elements for array and object, 1 otherwise
+    size_t size() const;
+
+    // returns an invalid ValueRef if the key/index does not exist
+    ValueRef operator[](std::string_view key) const;
+    ValueRef operator[](size_t index) const;
+
+    // Index of this value's entry on the tape
+    size_t index() const { return index_; }
+
+private:
+    friend class Tape;
+
+    TapeTag tag() const { return static_cast<TapeTag>(tape_[index_] >> 56); }
+    uint64_t payload() const { return tape_[index_] & 0x00ff'ffff'ffff'ffff; }
+    // Index of the entry following this value
+    size_t next() const;
+    // For keys
+    ValueRef valueAfterKey() const { return ValueRef(tape_, strings_, index_ + 1); }
+    Iterator childBegin(bool object) const;
+    Iterator childEnd(bool object) const;
+
+    const uint64_t* tape_ = nullptr;
+    const char* strings_ = nullptr;
+    size_t index_ = 0;
+};
+
+struct ValueRef::Member {
+    std::string_view key;
+    ValueRef value;
+};
+
+// Iterates over the elements of an array or the members of an object
+class ValueRef::Iterator {
+public:
+    Iterator(ValueRef value, bool object) : value_(value), object_(object) { }
+
+    ValueRef operator*() const { return object_ ? value_.valueAfterKey() : value_; }
+    std::string_view key() const { return value_.asString(); }
+
+    Iterator& operator++()
+    {
+        value_.index_ = object_ ? value_.valueAfterKey().next() : value_.next();
+        return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return value_.index_ == other.value_.index_; }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+private:
+    friend class ValueRef;
+
+    ValueRef value_;
+    bool object_;
+};
+
+inline ValueRef::Iterator ValueRef::childBegin(bool object) const
+{
+    return Iterator(ValueRef(tape_, strings_, index_ + 1), object);
+}
+
+inline ValueRef::Iterator ValueRef::childEnd(bool object) const
+{
+    // The end entry of the array/object
+    return Iterator(ValueRef(tape_, strings_, next() - 1), object);
+}
+
+class ValueRef::ArrayView {
+public:
+    ArrayView(ValueRef array) : array_(array) { }
+
+    Iterator begin() const { return array_.childBegin(false); }
+    Iterator end() const { return array_.childEnd(false); }
+    size_t size() const { return array_.size(); }
+
+private:
+    ValueRef array_;
+};
+
+class ValueRef::ObjectView {
+public:
+    class Iterator {
+    public:
+        Iterator(ValueRef::Iterator it) : it_(it) { }
+        Member operator*() const { return { it_.key(), *it_ }; }
+        Iterator& operator++()
+        {
+            ++it_;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return it_ == other.it_; }
+        bool operator!=(const Iterator& other) const { return it_ != other.it_; }
+
+    private:
+        ValueRef::Iterator it_;
+    };
+
+    ObjectView(ValueRef object) : object_(object) { }
+
+    Iterator begin() const { return object_.childBegin(true); }
+    Iterator end() const { return object_.childEnd(true); }
+    size_t size() const { return object_.size(); }
+
+private:
+    ValueRef object_;
+};
+
+// Non-owning view of a tape and its strings, e.g. in a mapped file (see minijson_binary.hpp)
+class TapeView {
+public:
+    TapeView() = default;
+    TapeView(const uint64_t* entries, size_t numEntries, const char* strings, size_t stringsSize)
+        : entries_(entries), numEntries_(numEntries), strings_(strings), stringsSize_(stringsSize)
+    {
+    }
+
+    ValueRef root() const
+    {
+        return numEntries_ == 0 ? ValueRef() : ValueRef(entries_, strings_, 0);
+    }
+
+    ValueRef operator[](std::string_view key) const { return root()[key]; }
+    ValueRef operator[](size_t index) const { return root()[index]; }
+
+    const uint64_t* entries() const { return entries_; }
+    size_t numEntries() const { return numEntries_; }
+    const char* strings() const { return strings_; }
+    size_t stringsSize() const { return stringsSize_; }
+
+private:
+    const uint64_t* entries_ = nullptr;
+    size_t numEntries_ = 0;
+    const char* strings_ = nullptr;
+    size_t stringsSize_ = 0;
+};
+
+// A parse result stored as a flat tape (see TapeTag). The tape and all strings live in a single
+// allocation.
+class Tape {
+public:
+    Tape() = default;
+    Tape(const Tape&) = delete;
+    Tape(Tape&&) = default;
+    Tape& operator=(const Tape&) = delete;
+    Tape& operator=(Tape&&) = default;
+
+    ValueRef root() const { return view().root(); }
+    TapeView view() const { return TapeView(entries(), numEntries_, strings(), stringsSize_); }
+
+    // Convenience forwarding to root()
+    ValueRef operator[](std::string_view key) const { return root()[key]; }
+    ValueRef operator[](size_t index) const { return root()[index]; }
+
+    const uint64_t* entries() const { return data_.get(); }
+    size_t numEntries() const { return numEntries_; }
+    const char* strings() const { return reinterpret_cast<const char*>(data_.get() + numEntries_); }
+    size_t stringsSize() const { return stringsSize_; }
+
+private:
+    friend class detail::TapeBuilder;
+
+    std::unique_ptr<uint64_t[]> data_;
+    size_t numEntries_ = 0;
+    size_t stringsSize_ = 0;
+};
+
+// Like parse, the source has to be a single value. zeroCopyStrings is ignored, because all strings
+// are copied into the tape anyway. Sources of 4 GiB or more fail with SourceTooLarge, because
+// entries refer to each other with 32-bit indices.
+Result<Tape> parseTape(std::string_view source, const ParseOptions& options = {});
+}
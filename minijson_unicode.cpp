@@ -0,0 +1,64 @@
+#include "minijson_unicode.hpp"
+
+#include "minijson_scan.hpp"
+
+namespace {
+bool isContinuation(unsigned char ch)
+{
+    return (ch & 0xc0) == 0x80;
+}
+
+// The length of the valid sequence at `p` or 0
+size_t getSequenceLength(const unsigned char* p, size_t available)
+{
+    const auto lead = p[0];
+    // The ranges of the second byte exclude overlong encodings, surrogates and code points above
+    // U+10FFFF (see the table in RFC 3629)
+    unsigned char min = 0x80;
+    unsigned char max = 0xbf;
+    size_t length;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        min = lead == 0xe0 ? 0xa0 : 0x80;
+        max = lead == 0xed ? 0x9f : 0xbf;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        min = lead == 0xf0 ? 0x90 : 0x80;
+        max = lead == 0xf4 ? 0x8f : 0xbf;
+    } else {
+        return 0;
+    }
+    if (available < length || p[1] < min || p[1] > max) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; ++i) {
+        if (!isContinuation(p[i])) {
+            return 0;
+        }
+    }
+    return length;
+}
+}
+
+namespace minijson::detail {
+size_t findInvalidUtf8Slow(const char* data, size_t size, size_t pos)
+{
+    const auto bytes = reinterpret_cast<const unsigned char*>(data);
+    while (true) {
+        pos = findNonAscii(data, size, pos);
+        // Non-ASCII text often stays non-ASCII for a while
+        while (pos < size && bytes[pos] >= 0x80) {
+            const auto length = getSequenceLength(bytes + pos, size - pos);
+            if (length == 0) {
+                return pos;
+            }
+            pos += length;
+        }
+        if (pos >= size) {
+            return size;
+        }
+    }
+}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Decoding escapes and checking UTF-8, shared by the parsers and validate
+namespace minijson::detail {
+constexpr std::array<char, 256> makeEscapeTable()
+{
+    std::array<char, 256> table {};
+    table['"'] = '"';
+    table['\\'] = '\\';
+    table['/'] = '/';
+    table['b'] = '\b';
+    table['f'] = '\f';
+    table['n'] = '\n';
+    table['r'] = '\r';
+    table['t'] = '\t';
+    return table;
+}
+
+// What the character after a backslash stands for. 0 for 'u' and invalid escapes.
+inline constexpr std::array<char, 256> escapeTable = makeEscapeTable();
+
+constexpr std::array<int8_t, 256> makeHexTable()
+{
+    std::array<int8_t, 256> table {};
+    for (auto& value : table) {
+        value = -1;
+    }
+    for (int i = 0; i < 10; ++i) {
+        table['0' + i] = static_cast<int8_t>(i);
+    }
+    for (int i = 0; i < 6; ++i) {
+        table['a' + i] = static_cast<int8_t>(10 + i);
+        table['A' + i] = static_cast<int8_t>(10 + i);
+    }
+    return table;
+}
+
+inline constexpr std::array<int8_t, 256> hexTable = makeHexTable();
+
+// The four hex digits at `p` or -1
+inline int32_t decodeHex4(const char* p)
+{
+    int32_t value = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        const auto digit = hexTable[static_cast<unsigned char>(p[i])];
+        if (digit < 0) {
+            return -1;
+        }
+        value = value << 4 | digit;
+    }
+    return value;
+}
+
+// Decodes a \u escape from right after the 'u', including the second half of a surrogate pair.
+// Returns the number of characters consumed (4 or 10) or 0 if the escape is invalid or
+// incomplete. Unpaired surrogates are invalid.
+inline size_t decodeUnicodeEscape(const char* p, const char* end, uint32_t& codePoint)
+{
+    if (end - p < 4) {
+        return 0;
+    }
+    const auto first = decodeHex4(p);
+    if (first < 0 || (first >= 0xdc00 && first <= 0xdfff)) {
+        return 0;
+    }
+    if (first < 0xd800 || first > 0xdfff) {
+        codePoint = static_cast<uint32_t>(first);
+        return 4;
+    }
+    if (end - p < 10 || p[4] != '\\' || p[5] != 'u') {
+        return 0;
+    }
+    const auto second = decodeHex4(p + 6);
+    if (second < 0xdc00 || second > 0xdfff) {
+        return 0;
+    }
+    codePoint = 0x10000 + ((static_cast<uint32_t>(first) - 0xd800) << 10)
+        + (static_cast<uint32_t>(second) - 0xdc00);
+    return 10;
+}
+
+template <typename String>
+void appendUtf8(String& str, uint32_t codePoint)
+{
+    if (codePoint < 0x80) {
+        str.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        str.push_back(static_cast<char>(0xc0 | (codePoint >> 6)));
+        str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    } else if (codePoint < 0x10000) {
+        str.push_back(static_cast<char>(0xe0 | (codePoint >> 12)));
+        str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    } else {
+        str.push_back(static_cast<char>(0xf0 | (codePoint >> 18)));
+        str.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f)));
+        str.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f)));
+        str.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+    }
+}
+
+// The rest of findInvalidUtf8 once there is a non-ASCII byte
+size_t findInvalidUtf8Slow(const char* data, size_t size, size_t pos);
+
+// The first byte at or after `pos` that doesn't belong to a valid UTF-8 sequence (e.g. overlong
+// encodings, surrogates or sequences that are cut off at `size`) or `size` if there is none.
+// ASCII is skipped with SIMD, so this is about as fast as findStringSpecial for mostly ASCII text.
+inline size_t findInvalidUtf8(const char* data, size_t size, size_t pos)
+{
+    // Most strings are short and ASCII, which is checked here without a call
+    while (pos + 8 <= size) {
+        uint64_t word;
+        std::memcpy(&word, data + pos, sizeof(word));
+        if (word & 0x8080808080808080) {
+            return findInvalidUtf8Slow(data, size, pos);
+        }
+        pos += 8;
+    }
+    while (pos < size && static_cast<unsigned char>(data[pos]) < 0x80) {
+        pos++;
+    }
+    return pos < size ? findInvalidUtf8Slow(data, size, pos) : size;
+}
+}
@@ -0,0 +1,303 @@
+#include "minijson_validate.hpp"
+
+#include <cstdint>
+#include <vector>
+
+#include "minijson_scan.hpp"
+#include "minijson_unicode.hpp"
+
+namespace {
+using namespace minijson;
+
+bool isDigit(char ch)
+{
+    return ch >= '0' && ch <= '9';
+}
+
+// The same grammar as SaxParser, but only the open containers are tracked, one bit each
+class Validator {
+public:
+    Validator(std::string_view source, size_t maxDepth) : source_(source), maxDepth_(maxDepth) { }
+
+    ValidationResult run()
+    {
+        if (!parse()) {
+            return { code_, cursor_ };
+        }
+        skipWhitespace();
+        if (cursor_ < source_.size()) {
+            return { ErrorCode::TrailingCharacters, cursor_ };
+        }
+        return { ErrorCode::None, cursor_ };
+    }
+
+private:
+    bool fail(ErrorCode code)
+    {
+        code_ = code;
+        return false;
+    }
+
+    bool peek(char ch) const { return cursor_ < source_.size() && source_[cursor_] == ch; }
+
+    void skipWhitespace()
+    {
+        if (cursor_ < source_.size() && detail::isWhitespace(source_[cursor_])) {
+            cursor_++;
+            // Mostly a single space (e.g. after a colon), which isn't worth a scan
+            if (cursor_ < source_.size() && detail::isWhitespace(source_[cursor_])) {
+                cursor_ = detail::findNonWhitespace(source_.data(), source_.size(), cursor_ + 1);
+            }
+        }
+    }
+
+    uint64_t& getLevels(size_t depth)
+    {
+        return depth < maxValidationDepth ? levels_[depth / 64]
+                                          : deepLevels_[(depth - maxValidationDepth) / 64];
+    }
+
+    bool isObject() { return (getLevels(depth_ - 1) >> ((depth_ - 1) % 64)) & 1; }
+
+    bool push(bool isObject)
+    {
+        if (depth_ >= maxDepth_) {
+            return fail(ErrorCode::MaxDepthExceeded);
+        }
+        if (depth_ >= maxValidationDepth
+            && (depth_ - maxValidationDepth) / 64 == deepLevels_.size()) {
+            deepLevels_.push_back(0);
+        }
+        const auto bit = uint64_t(1) << (depth_ % 64);
+        auto& word = getLevels(depth_);
+        word = isObject ? word | bit : word & ~bit;
+        depth_++;
+        cursor_++;
+        return true;
+    }
+
+    bool parse()
+    {
+        while (true) {
+            // A value
+            skipWhitespace();
+            if (cursor_ >= source_.size()) {
+                return fail(ErrorCode::ExpectedValue);
+            }
+            const auto c = source_[cursor_];
+            if (c == '[' || c == '{') {
+                if (!push(c == '{')) {
+                    return false;
+                }
+                skipWhitespace();
+                if (cursor_ >= source_.size()) {
+                    return fail(c == '{' ? ErrorCode::UnterminatedObject
+                                         : ErrorCode::UnterminatedArray);
+                } else if (peek(c == '{' ? '}' : ']')) {
+                    cursor_++;
+                    depth_--;
+                } else if (c == '[') {
+                    continue;
+                } else if (!parseKey()) {
+                    return false;
+                } else {
+                    continue;
+                }
+            } else if (c == '"') {
+                if (!parseString()) {
+                    return false;
+                }
+            } else if (!parseLiteral()) {
+                return false;
+            }
+
+            // After a value: close containers until there is another value
+            while (true) {
+                if (depth_ == 0) {
+                    return true;
+                }
+                skipWhitespace();
+                const auto object = isObject();
+                if (cursor_ >= source_.size()) {
+                    return fail(object ? ErrorCode::UnterminatedObject
+                                       : ErrorCode::UnterminatedArray);
+                }
+                if (source_[cursor_] == (object ? '}' : ']')) {
+                    cursor_++;
+                    depth_--;
+                    continue;
+                }
+                if (source_[cursor_] != ',') {
+                    return fail(ErrorCode::ExpectedSeparator);
+                }
+                cursor_++;
+                skipWhitespace();
+                // The other bracket is just not a value or a key, like in parse
+                if (peek(object ? '}' : ']')) {
+                    return fail(ErrorCode::TrailingComma);
+                }
+                if (object && !parseKey()) {
+                    return false;
+                }
+                break;
+            }
+        }
+    }
+
+    // The key and the colon of an object member
+    bool parseKey()
+    {
+        if (!peek('"')) {
+            return fail(ErrorCode::ExpectedKey);
+        }
+        if (!parseString()) {
+            return false;
+        }
+        skipWhitespace();
+        if (!peek(':')) {
+            return fail(ErrorCode::ExpectedColon);
+        }
+        cursor_++;
+        return true;
+    }
+
+    bool parseString()
+    {
+        const auto data = source_.data();
+        const auto size = source_.size();
+        cursor_++;
+        while (true) {
+            const auto start = cursor_;
+            cursor_ = detail::findStringSpecial(data, size, cursor_);
+            // While the characters are still in the cache
+            const auto invalid = detail::findInvalidUtf8(data, cursor_, start);
+            if (invalid < cursor_) {
+                cursor_ = invalid;
+                return fail(ErrorCode::InvalidUtf8);
+            }
+            if (cursor_ >= size) {
+                return fail(ErrorCode::UnterminatedString);
+            }
+            const auto c = data[cursor_];
+            if (c == '"') {
+                cursor_++;
+                return true;
+            } else if (c != '\\') {
+                return fail(ErrorCode::ControlCharacter);
+            }
+
+            cursor_++;
+            if (cursor_ >= size) {
+                return fail(ErrorCode::UnterminatedString);
+            }
+            const auto escape = data[cursor_];
+            if (detail::escapeTable[static_cast<unsigned char>(escape)]) {
+                cursor_++;
+            } else if (escape == 'u') {
+                uint32_t codePoint;
+                const auto length
+                    = detail::decodeUnicodeEscape(data + cursor_ + 1, data + size, codePoint);
+                if (length == 0) {
+                    return fail(ErrorCode::InvalidUnicodeEscape);
+                }
+                cursor_ += 1 + length;
+            } else {
+                return fail(ErrorCode::InvalidEscape);
+            }
+        }
+    }
+
+    // The literal has to end here, so e.g. "nullx" is an error like in the parser
+    bool matchLiteral(std::string_view literal)
+    {
+        const auto end = cursor_ + literal.size();
+        if (source_.compare(cursor_, literal.size(), literal) != 0
+            || (end < source_.size() && detail::isValueChar(source_[end]))) {
+            return false;
+        }
+        cursor_ = end;
+        return true;
+    }
+
+    bool skipDigits()
+    {
+        const auto start = cursor_;
+        while (cursor_ < source_.size() && isDigit(source_[cursor_])) {
+            cursor_++;
+        }
+        return cursor_ > start;
+    }
+
+    bool parseNumber()
+    {
+        const auto start = cursor_;
+        if (peek('-')) {
+            cursor_++;
+        }
+        // No leading zeros
+        if (peek('0')) {
+            cursor_++;
+        } else if (!skipDigits()) {
+            return false;
+        }
+        if (peek('.')) {
+            cursor_++;
+            if (!skipDigits()) {
+                return false;
+            }
+        }
+        if (peek('e') || peek('E')) {
+            cursor_++;
+            if (peek('+') || peek('-')) {
+                cursor_++;
+            }
+            if (!skipDigits()) {
+                return false;
+            }
+        }
+        if (cursor_ < source_.size() && detail::isValueChar(source_[cursor_])) {
+            return false;
+        }
+        return cursor_ > start;
+    }
+
+    // null, bool or number
+    bool parseLiteral()
+    {
+        const auto c = source_[cursor_];
+        if (c == 'n' || c == 't' || c == 'f') {
+            if (matchLiteral("null") || matchLiteral("true") || matchLiteral("false")) {
+                return true;
+            }
+            return fail(ErrorCode::InvalidLiteral);
+        }
+        if (c != '-' && !isDigit(c)) {
+            return fail(detail::isValueChar(c) ? ErrorCode::InvalidLiteral
+                                               : ErrorCode::ExpectedValue);
+        }
+        const auto start = cursor_;
+        if (!parseNumber()) {
+            cursor_ = start;
+            return fail(ErrorCode::InvalidNumber);
+        }
+        return true;
+    }
+
+    std::string_view source_;
+    size_t maxDepth_;
+    size_t cursor_ = 0;
+    ErrorCode code_ = ErrorCode::None;
+    size_t depth_ = 0;
+    // Bit i is set if the container at depth i is an object
+    uint64_t levels_[maxValidationDepth / 64] = {};
+    // The levels beyond those
+    std::vector<uint64_t> deepLevels_;
+};
+}
+
+namespace minijson {
+ValidationResult validate(std::string_view source, size_t maxDepth)
+{
+    return Validator(source, maxDepth).run();
+}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "minijson.hpp"
+
+namespace minijson {
+struct ValidationResult {
+    ErrorCode code = ErrorCode::None;
+    // Where the error is. If the source is valid, its size.
+    size_t offset = 0;
+
+    explicit operator bool() const { return code == ErrorCode::None; }
+};
+
+// Nesting deeper than this is an error for validate by default, like for parse (see
+// ParseOptions::maxDepth)
+constexpr size_t maxValidationDepth = 1024;
+
+// Checks that the source is exactly one JSON value (surrounded by whitespace) according to RFC
+// 8259 without building anything or allocating. This is stricter than parse, which accepts
+// control characters in strings. Strings always have to be valid UTF-8 (see
+// ParseOptions::validateUtf8) and surrogates in \u escapes have to be paired. Numbers are only
+// checked against the grammar, so ones that don't fit into a double (which parse rejects) are
+// valid.
+// Pass the ParseOptions::maxDepth of a later parse as maxDepth, so both accept the same nesting.
+// Only limits above maxValidationDepth need to allocate (an eighth of a byte per level).
+ValidationResult validate(std::string_view source, size_t maxDepth = maxValidationDepth);
+}
@@ -0,0 +1,290 @@
+#include "minijson_writer.hpp"
+
+#include <cassert>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+
+#include <unistd.h>
+
+#include "minijson_scan.hpp"
+
+namespace {
+// Large enough that the sink is called rarely, small enough to stay in L1/L2
+constexpr size_t bufferSize = 16 * 1024;
+}
+
+namespace minijson {
+void FileSink::write(const char* data, size_t size)
+{
+    if (std::fwrite(data, 1, size, file_) != size) {
+        ok_ = false;
+    }
+}
+
+void FdSink::write(const char* data, size_t size)
+{
+    while (size > 0) {
+        const auto n = ::write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ok_ = false;
+            return;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+Writer::Writer(Sink& sink, const WriteOptions& options)
+    : sink_(sink)
+    , options_(options)
+    , buffer_(new char[bufferSize])
+    , capacity_(bufferSize)
+{
+}
+
+Writer::~Writer()
+{
+    flush();
+}
+
+void Writer::flush()
+{
+    if (size_ > 0) {
+        sink_.write(buffer_.get(), size_);
+        size_ = 0;
+    }
+}
+
+void Writer::newline(size_t depth)
+{
+    append('\n');
+    for (size_t i = 0; i < options_.indentLevel + depth; ++i) {
+        append(options_.indent);
+    }
+}
+
+void Writer::beforeValue()
+{
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (empty_.empty()) {
+        return;
+    }
+    if (!empty_.back()) {
+        append(',');
+    }
+    empty_.back() = false;
+    if (options_.pretty) {
+        newline(empty_.size());
+    }
+}
+
+void Writer::null()
+{
+    beforeValue();
+    append("null", 4);
+}
+
+void Writer::boolean(bool value)
+{
+    beforeValue();
+    if (value) {
+        append("true", 4);
+    } else {
+        append("false", 5);
+    }
+}
+
+void Writer::number(double value)
+{
+    if (!std::isfinite(value)) {
+        null();
+        return;
+    }
+    beforeValue();
+    // Shortest representation that round-trips
+    char buf[32];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    assert(res.ec == std::errc());
+    append(buf, static_cast<size_t>(res.ptr - buf));
+}
+
+void Writer::number(int64_t value)
+{
+    beforeValue();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    append(buf, static_cast<size_t>(res.ptr - buf));
+}
+
+void Writer::number(uint64_t value)
+{
+    beforeValue();
+    char buf[24];
+    const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+    append(buf, static_cast<size_t>(res.ptr - buf));
+}
+
+void Writer::writeEscaped(std::string_view str)
+{
+    static constexpr char hexDigits[] = "0123456789abcdef";
+    append('"');
+    size_t cursor = 0;
+    while (cursor < str.size()) {
+        // Copy everything up to the next character that needs escaping in one go
+        const auto special = detail::findStringSpecial(str.data(), str.size(), cursor);
+        append(str.data() + cursor, special - cursor);
+        if (special >= str.size()) {
+            break;
+        }
+        const auto ch = str[special];
+        switch (ch) {
+        case '"':
+            append("\\\"", 2);
+            break;
+        case '\\':
+            append("\\\\", 2);
+            break;
+        case '\b':
+            append("\\b", 2);
+            break;
+        case '\f':
+            append("\\f", 2);
+            break;
+        case '\n':
+            append("\\n", 2);
+            break;
+        case '\r':
+            append("\\r", 2);
+            break;
+        case '\t':
+            append("\\t", 2);
+            break;
+        default: {
+            const auto byte = static_cast<unsigned char>(ch);
+            const char esc[] = { '\\', 'u', '0', '0', hexDigits[byte >> 4], hexDigits[byte & 0xf] };
+            append(esc, sizeof(esc));
+        }
+        }
+        cursor = special + 1;
+    }
+    append('"');
+}
+
+void Writer::string(std::string_view str)
+{
+    beforeValue();
+    writeEscaped(str);
+}
+
+void Writer::key(std::string_view key)
+{
+    beforeValue();
+    writeEscaped(key);
+    if (options_.pretty) {
+        append(": ", 2);
+    } else {
+        append(':');
+    }
+    afterKey_ = true;
+}
+
+void Writer::startContainer(char c)
+{
+    beforeValue();
+    append(c);
+    empty_.push_back(true);
+}
+
+void Writer::endContainer(char c)
+{
+    assert(!empty_.empty());
+    empty_.pop_back();
+    if (options_.pretty) {
+        newline(empty_.size());
+    }
+    append(c);
+}
+
+void Writer::startArray()
+{
+    startContainer('[');
+}
+
+void Writer::endArray()
+{
+    endContainer(']');
+}
+
+void Writer::startObject()
+{
+    startContainer('{');
+}
+
+void Writer::endObject()
+{
+    endContainer('}');
+}
+
+void Writer::value(const JsonValue& value)
+{
+    assert(value.isValid());
+    switch (value.type()) {
+    case JsonValue::Type::Null:
+        null();
+        break;
+    case JsonValue::Type::Bool:
+        boolean(value.asBool());
+        break;
+    case JsonValue::Type::Number:
+        if (value.isInt()) {
+            number(value.asInt());
+        } else if (value.isUInt()) {
+            number(value.asUInt());
+        } else {
+            number(value.asNumber());
+        }
+        break;
+    case JsonValue::Type::String:
+        string(value.asString());
+        break;
+    case JsonValue::Type::Array:
+        startArray();
+        for (const auto& elem : value.asArray()) {
+            this->value(elem);
+        }
+        endArray();
+        break;
+    case JsonValue::Type::Object:
+        startObject();
+        for (const auto& [k, v] : value.asObject()) {
+            key(k);
+            this->value(v);
+        }
+        endObject();
+        break;
+    default:
+        assert(false && "Invalid JsonValue type");
+    }
+}
+
+void write(const JsonValue& value, Sink& sink, const WriteOptions& options)
+{
+    Writer writer(sink, options);
+    writer.value(value);
+}
+
+std::string toString(const JsonValue& value, const WriteOptions& options)
+{
+    std::string str;
+    StringSink sink(str);
+    write(value, sink, options);
+    return str;
+}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "minijson.hpp"
+
+namespace minijson {
+// Where a Writer's output goes. The Writer buffers, so write is called with large chunks.
+class Sink {
+public:
+    virtual ~Sink() = default;
+    virtual void write(const char* data, size_t size) = 0;
+};
+
+class StringSink : public Sink {
+public:
+    StringSink(std::string& str) : str_(str) { }
+    void write(const char* data, size_t size) override { str_.append(data, size); }
+
+private:
+    std::string& str_;
+};
+
+class FileSink : public Sink {
+public:
+    FileSink(std::FILE* file) : file_(file) { }
+    void write(const char* data, size_t size) override;
+    bool ok() const { return ok_; }
+
+private:
+    std::FILE* file_;
+    bool ok_ = true;
+};
+
+// Writes to a file descriptor (POSIX)
+class FdSink : public Sink {
+public:
+    FdSink(int fd) : fd_(fd) { }
+    void write(const char* data, size_t size) override;
+    bool ok() const { return ok_; }
+
+private:
+    int fd_;
+    bool ok_ = true;
+};
+
+struct WriteOptions {
+    // If false, no whitespace is written at all
+    bool pretty = false;
+    std::string_view indent = "  ";
+    // Initial indentation level (only if pretty)
+    size_t indentLevel = 0;
+};
+
+// Writes JSON piece by piece. Separators and indentation are taken care of, but it is up to the
+// caller to produce a valid sequence of calls (e.g. a key before every value in an object).
+// NaN and infinities are written as null, because JSON can't represent them.
+class Writer {
+public:
+    Writer(Sink& sink, const WriteOptions& options = {});
+    ~Writer(); // flushes
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    void null();
+    void boolean(bool value);
+    void number(double value);
+    void number(int64_t value);
+    void number(uint64_t value);
+    void string(std::string_view str);
+    void key(std::string_view key);
+    void startArray();
+    void endArray();
+    void startObject();
+    void endObject();
+
+    void value(const JsonValue& value);
+
+    void flush();
+
+private:
+    void beforeValue();
+    void newline(size_t depth);
+    void startContainer(char c);
+    void endContainer(char c);
+    void writeEscaped(std::string_view str);
+
+    void append(const char* data, size_t size)
+    {
+        if (size > capacity_ - size_) {
+            flush();
+            if (size > capacity_) {
+                sink_.write(data, size);
+                return;
+            }
+        }
+        std::memcpy(buffer_.get() + size_, data, size);
+        size_ += size;
+    }
+    void append(std::string_view str) { append(str.data(), str.size()); }
+    void append(char c)
+    {
+        if (size_ == capacity_) {
+            flush();
+        }
+        buffer_[size_++] = c;
+    }
+
+    Sink& sink_;
+    WriteOptions options_;
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;
+    size_t size_ = 0;
+    // One entry per open container. true if the container is still empty.
+    std::vector<bool> empty_;
+    // The next value is the value to a key, so it doesn't need a separator
+    bool afterKey_ = false;
+};
+
+void write(const JsonValue& value, Sink& sink, const WriteOptions& options = {});
+std::string toString(const JsonValue& value, const WriteOptions& options = {});
+}
@@ -1,7 +1,38 @@
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 #include "minijson.hpp"
+#include "minijson_arena.hpp"
+#include "minijson_binary.hpp"
+#include "minijson_bind.hpp"
+#include "minijson_document.hpp"
+#include "minijson_file.hpp"
+#include "minijson_frozen.hpp"
+#include "minijson_intern.hpp"
+#include "minijson_lazy.hpp"
+#include "minijson_ndjson.hpp"
+#include "minijson_pointer.hpp"
+#include "minijson_sax.hpp"
+#include "minijson_stats.hpp"
+#include "minijson_stream.hpp"
+#include "minijson_tape.hpp"
+#include "minijson_validate.hpp"
+#include "minijson_writer.hpp"
+
+struct Item {
+    int id = 0;
+    std::string name;
+    std::optional<std::vector<double>> values;
+};
+
+template <>
+struct minijson::Binding<Item> {
+    static constexpr auto fields = std::make_tuple(
+        MINIJSON_FIELD(Item, id), MINIJSON_FIELD(Item, name), minijson::field("v", &Item::values));
+};
 
 void printValue(const minijson::JsonValue& value, size_t indent = 0)
 {
@@ -69,8 +100,7 @@ int main()
     const auto res = minijson::parse(src);
     if (!res) {
         const auto& err = res.error();
-        std::cerr << "Could not parse json: " << err.message << " at " << err.cursor << std::endl;
-        std::cout << minijson::getContext(src, err.cursor) << std::endl;
+        std::cerr << "Could not parse json: " << err.describe(src) << std::endl;
         return 1;
     }
 
@@ -89,5 +119,473 @@ int main()
         std::cout << "<empty>" << std::endl;
     }
 
+    minijson::ParseOptions zeroCopy;
+    zeroCopy.zeroCopyStrings = true;
+    const auto refRes = minijson::parse(src, zeroCopy);
+    assert(refRes);
+    assert((*refRes)["b"].asString() == "hello");
+    assert((*refRes)["b"].asString().isRef());
+    assert((*refRes)["b"].asString().data() >= src.data());
+
+    std::string bigObject = "{";
+    for (int i = 0; i < 100; ++i) {
+        bigObject += (i > 0 ? ",\"k" : "\"k") + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    bigObject += "}";
+    const auto big = minijson::parse(bigObject);
+    assert(big && big->size() == 100);
+    assert((*big)["k42"].asNumber() == 42.0);
+    assert(!(*big)["k100"].isValid());
+    assert(big->asObject().begin()->first == "k0");
+
+    const auto tape = minijson::parseTape(src);
+    assert(tape);
+    assert(tape->root().size() == 6);
+    assert((*tape)["arr"][1]["y"].asNumber() == 5.0);
+    assert((*tape)["obj"]["foo"].asString() == "bar");
+    assert(!(*tape)["arr"][2].isValid());
+    for (const auto& [key, value] : (*tape)["obj"].asObject()) {
+        std::cout << key << ": " << value.asString() << std::endl;
+    }
+
+    minijson::StreamParser stream;
+    for (size_t i = 0; i < src.size(); i += 7) {
+        [[maybe_unused]] const auto ok = stream.feed(src.substr(i, 7));
+        assert(ok);
+    }
+    const auto streamed = stream.finish();
+    assert(streamed);
+    assert(streamed->dump() == doc.dump());
+    minijson::StreamParser deepStream;
+    assert(deepStream.error().code == minijson::ErrorCode::None);
+    [[maybe_unused]] const auto deepOk = deepStream.feed(std::string(300000, '['));
+    assert(!deepOk && deepStream.error().code == minijson::ErrorCode::MaxDepthExceeded);
+    assert(deepStream.error().cursor == 1024 && !deepStream.finish());
+    [[maybe_unused]] const auto streamError = [](std::string_view source) {
+        minijson::StreamParser parser;
+        for (size_t i = 0; i < source.size(); i += 2) {
+            parser.feed(source.substr(i, 2));
+        }
+        const auto res = parser.finish();
+        return res ? std::optional<minijson::Error>() : res.error();
+    };
+    assert(streamError("[1,]")->code == minijson::ErrorCode::TrailingComma);
+    assert(streamError("[tru]")->code == minijson::ErrorCode::InvalidLiteral);
+    assert(streamError("[fals")->cursor == 1 && streamError("[-x]")->cursor == 1);
+    assert(streamError("[-x]")->code == minijson::ErrorCode::InvalidNumber);
+    assert(streamError(R"(["\u12g4"])")->cursor == 3 && streamError("[1")->cursor == 2);
+    assert(streamError("[1")->code == minijson::ErrorCode::ExpectedSeparator);
+    assert(streamError("{\"a\": 1 ,\n}")->cursor == 10);
+    assert(streamError("[1]]")->code == minijson::ErrorCode::TrailingCharacters);
+    assert(streamError("[1] garbage")->cursor == 4 && streamError("1 2")->cursor == 2);
+    assert(!streamError(" [1, {}] \r\n") && !streamError("[ ]") && !streamError("{ }"));
+
+    // Sums up all numbers until it finds "arr"
+    struct SumHandler : minijson::SaxHandler {
+        double sum = 0.0;
+        bool onNumber(double value)
+        {
+            sum += value;
+            return true;
+        }
+        bool onKey(std::string_view key) { return key != "arr"; }
+    };
+    SumHandler sumHandler;
+    [[maybe_unused]] const auto saxRes = minijson::parseSax(src, sumHandler);
+    assert(!saxRes && saxRes.error().code == minijson::ErrorCode::StoppedByHandler);
+    assert(sumHandler.sum == 12.0);
+
+    minijson::NdjsonOptions ndjsonOptions;
+    ndjsonOptions.numThreads = 2;
+    ndjsonOptions.batchSize = 1;
+    const auto records
+        = minijson::parseNdjson("{\"a\": 1}\n\n[1, 2]\n{\"a\": }\n3 4\n", ndjsonOptions);
+    assert(records.size() == 4);
+    assert(records[0].value && (*records[0].value)["a"].asNumber() == 1.0);
+    assert(records[1].line == 3 && records[1].value->size() == 2);
+    assert(!records[2].value && records[2].line == 4 && records[2].value.error().cursor == 23);
+    assert(!records[3].value && records[3].line == 5);
+
+    const auto numbers = minijson::parse("[9007199254740993, 18446744073709551615, -12, 1.5e3]");
+    assert(numbers);
+    assert((*numbers)[0].asInt() == 9007199254740993);
+    assert((*numbers)[1].asUInt() == 18446744073709551615u);
+    assert((*numbers)[2].isInt() && (*numbers)[2].asNumber() == -12.0);
+    assert(!(*numbers)[3].isInteger() && (*numbers)[3].asNumber() == 1500.0);
+    assert(!minijson::parse("01") && !minijson::parse("1.") && !minijson::parse("nan"));
+
+    const auto written = minijson::parse(R"({"a": [1.5, -3, "x\"\n"], "b": {}, "c": null})");
+    assert(written);
+    assert(minijson::toString(*written) == R"({"a":[1.5,-3,"x\"\n"],"b":{},"c":null})");
+    [[maybe_unused]] const auto compact = minijson::toString(*written);
+    assert(minijson::toString(*minijson::parse(compact)) == compact);
+    assert(minijson::JsonValue(0.1).dump() == "0.1");
+    assert(minijson::JsonValue(minijson::String("\x01\t")).dump() == R"("\u0001\t")");
+
+    const auto path = std::string(P_tmpdir) + "/minijson-test.json";
+    FILE* f = std::fopen(path.c_str(), "wb");
+    assert(f);
+    std::fputs(R"({"mapped": "yes"})", f);
+    std::fclose(f);
+    const auto fileDoc = minijson::parseFile(path, zeroCopy);
+    assert(fileDoc && fileDoc->root()["mapped"].asString().isRef());
+    assert(fileDoc->root()["mapped"].asString() == "yes");
+    std::remove(path.c_str());
+    assert(!minijson::parseFile(path));
+
+    assert(!minijson::parse("[1,") && !minijson::parse("{"));
+    const auto deep = std::string(2000, '[') + std::string(2000, ']');
+    const auto deepRes = minijson::parse(deep);
+    assert(!deepRes && deepRes.error().cursor == 1024);
+    minijson::ParseOptions deeper;
+    deeper.maxDepth = 4096;
+    assert(minijson::parse(deep, deeper));
+
+    const auto lazy
+        = minijson::lazy::parse(R"({"skip": [{"x": "]"}, [[]]], "a\n": {"b": [1, 2.5]}})");
+    assert(lazy && lazy->isObject() && lazy->size() == 2);
+    assert((*lazy)["a\n"]["b"][1].asNumber() == 2.5 && (*lazy)["a\n"]["b"][0].isInt());
+    assert(!(*lazy)["missing"].isValid() && !(*lazy)["skip"][5].isValid());
+    size_t numLazyMembers = 0;
+    for (const auto& [key, value] : lazy->asObject()) {
+        assert(key == "skip" ? value.isArray() : value.isObject());
+        numLazyMembers++;
+    }
+    assert(numLazyMembers == 2);
+    assert((*lazy)["skip"][0].materialize()->asObject().size() == 1);
+
+    minijson::Document document;
+    [[maybe_unused]] const auto documentOk = document.parse("[1, 2");
+    assert(!documentOk && document.error().cursor == 5);
+    assert(!document.root().isValid());
+    for (int i = 0; i < 3; ++i) {
+        [[maybe_unused]] const auto ok = document.parse(R"({"a": [1, 2, 3], "b": "some string"})");
+        assert(ok && document.root()["a"].size() == 3 && document.root()["b"].isString());
+    }
+    document.reset();
+    assert(!document.root().isValid());
+    // The arena reserves at most 256 MiB up front and grows from there
+    minijson::Document largeDocument;
+    const auto largeSource = "\"" + std::string(size_t(32) << 20, 'x') + "\"";
+    [[maybe_unused]] const auto largeOk = largeDocument.parse(largeSource);
+    assert(largeOk && largeDocument.root().asString().size() == largeSource.size() - 2);
+    assert(static_cast<minijson::Arena*>(largeDocument.memoryResource())->capacity()
+        < largeSource.size() * 9);
+
+    minijson::ParallelOptions parallelOptions;
+    parallelOptions.numThreads = 3;
+    parallelOptions.batchSize = 1;
+    minijson::ParallelDocument parallel(parallelOptions);
+    const auto arraySource = std::string(R"([{"a": "],\""}, [1, [2]], "x", null, {}, []])");
+    [[maybe_unused]] auto parallelOk = parallel.parse(arraySource);
+    assert(parallelOk && parallel.root().size() == 6);
+    assert(parallel.root().dump() == minijson::parse(arraySource)->dump());
+    parallelOk = parallel.parse(" [ ] ");
+    assert(parallelOk && parallel.root().isArray() && parallel.root().size() == 0);
+    parallelOk = parallel.parse("[1, 2 3]");
+    assert(!parallelOk && parallel.error().cursor == 6);
+    parallelOk = parallel.parse(R"({"a": 1})");
+    assert(parallelOk && parallel.root()["a"].isInt());
+
+    minijson::KeyInterner interner;
+    minijson::ParseOptions internOptions;
+    internOptions.keyInterner = &interner;
+    const auto internedRecords
+        = minijson::parse(R"([{"long key name": 1}, {"long key name": 2}])", internOptions);
+    assert(internedRecords && interner.size() == 1);
+    assert((*internedRecords)[0].asObject().begin()->first.isRef());
+    assert((*internedRecords)[0].asObject().begin()->first.data()
+        == (*internedRecords)[1].asObject().begin()->first.data());
+    minijson::KeyInterner schema { "id" };
+    internOptions.keyInterner = &schema;
+    const auto unknownKey = minijson::parse(R"({"id": 1, "other": 2})", internOptions);
+    assert(unknownKey && (*unknownKey)["other"].isInt() && schema.size() == 1);
+
+    const auto items = minijson::parseAs<std::vector<Item>>(
+        R"([{"id": 1, "name": "a", "v": [1.5]}, {"extra": [{}], "id": 2, "id": 3, "v": null}])");
+    assert(items && items->size() == 2 && (*items)[1].id == 2 && !(*items)[1].values);
+    assert((*items)[0].values->at(0) == 1.5);
+    assert(minijson::serialize(*items)
+        == R"([{"id":1,"name":"a","v":[1.5]},{"id":2,"name":"","v":null}])");
+    const auto badItem = minijson::parseAs<Item>(R"({"id": 1e10})");
+    assert(!badItem && badItem.error().code == minijson::ErrorCode::ExpectedInteger);
+    const auto trailingItem = minijson::parseAs<Item>(R"({"id": 1} trailing garbage)");
+    assert(!trailingItem && trailingItem.error().code == minijson::ErrorCode::TrailingCharacters);
+    assert(trailingItem.error().cursor == 10 && minijson::parseAs<Item>(" {\"id\": 1}\n"));
+
+    const auto pointerSource = std::string(R"({"a": {"b/c": [10, {"~d": true}]}, "0": 1})");
+    const auto pointerRoot = minijson::parse(pointerSource);
+    [[maybe_unused]] const auto pointerLazy = minijson::lazy::parse(pointerSource);
+    const auto pointer = minijson::JsonPointer::compile("/a/b~1c/1/~0d");
+    assert(pointer && pointer->size() == 4 && pointer->token(1) == "b/c");
+    assert(pointer->evaluate(*pointerRoot)->asBool() && pointer->evaluate(*pointerLazy).asBool());
+    assert(minijson::JsonPointer::compile("/0")->evaluate(*pointerRoot)->asInt() == 1);
+    assert(!minijson::JsonPointer::compile("/a/b~1c/01")->evaluate(*pointerRoot));
+    assert(!minijson::JsonPointer::compile("/a/b~1c/2")->evaluate(*pointerLazy).isValid());
+    assert(minijson::JsonPointer().evaluate(*pointerRoot) == &*pointerRoot);
+    assert(!minijson::JsonPointer::compile("a") && !minijson::JsonPointer::compile("/~2"));
+
+    assert(!minijson::parse("[1, 2,]") && !minijson::parse(R"({"a": 1,})"));
+    assert(minijson::parse("[1] x").error().cursor == 4 && minijson::parse(" [1] \r\n"));
+    assert(minijson::validate(R"( {"a": [1, -0.5e+3, "\u00e9\n", null, true], "b": {}} )"));
+    assert(minijson::validate("[]").offset == 2);
+    using minijson::ErrorCode;
+    [[maybe_unused]] const auto invalid
+        = [](std::string_view source, ErrorCode code, size_t offset) {
+              const auto res = minijson::validate(source);
+              return res.code == code && res.offset == offset;
+          };
+    assert(invalid("", ErrorCode::ExpectedValue, 0));
+    assert(invalid("[1,]", ErrorCode::TrailingComma, 3));
+    assert(invalid("{\"a\": 1 , }", ErrorCode::TrailingComma, 10));
+    assert(invalid("[1,}", ErrorCode::ExpectedValue, 3));
+    assert(invalid("{\"a\": 1, ]", ErrorCode::ExpectedKey, 9));
+    assert(invalid("[1] 2", ErrorCode::TrailingCharacters, 4));
+    assert(invalid("[01]", ErrorCode::InvalidNumber, 1));
+    assert(invalid("1.", ErrorCode::InvalidNumber, 0));
+    assert(invalid("[nul]", ErrorCode::InvalidLiteral, 1));
+    assert(invalid("[\"a\tb\"]", ErrorCode::ControlCharacter, 3));
+    assert(invalid(R"(["\x"])", ErrorCode::InvalidEscape, 3));
+    assert(invalid(R"(["\u12g4"])", ErrorCode::InvalidUnicodeEscape, 3));
+    assert(invalid(R"(["\ud83d"])", ErrorCode::InvalidUnicodeEscape, 3));
+    assert(invalid("[\"\xc3\x28\"]", ErrorCode::InvalidUtf8, 2));
+    assert(invalid(R"({"a" 1})", ErrorCode::ExpectedColon, 5));
+    assert(invalid("{1: 2}", ErrorCode::ExpectedKey, 1));
+    assert(invalid("[1 2]", ErrorCode::ExpectedSeparator, 3));
+    assert(invalid("[[1]", ErrorCode::UnterminatedArray, 4));
+    assert(invalid("{\"a\": {}", ErrorCode::UnterminatedObject, 8));
+    assert(invalid(R"(["abc)", ErrorCode::UnterminatedString, 5));
+    assert(invalid(std::string(minijson::maxValidationDepth + 1, '['),
+        ErrorCode::MaxDepthExceeded, minijson::maxValidationDepth));
+    assert(minijson::validate(deep, deeper.maxDepth));
+    [[maybe_unused]] const auto tooDeep = minijson::validate(deep, 1500);
+    assert(tooDeep.code == ErrorCode::MaxDepthExceeded && tooDeep.offset == 1500);
+    assert(minijson::validate("[[{\"a\": [1]}]]", 3).code == ErrorCode::MaxDepthExceeded);
+
+    const std::string_view unicodeSource = R"(["\u00e9\u20ac\ud83d\ude00\u0041", 1])";
+    const auto unicode = minijson::parse(unicodeSource);
+    assert(unicode && (*unicode)[0].asString() == "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\x41");
+    assert(minijson::parse(R"("\udc00")").error().code == ErrorCode::InvalidUnicodeEscape);
+    assert(minijson::parse(R"("\ud83dx")").error().code == ErrorCode::InvalidUnicodeEscape);
+    for (size_t chunkSize = 1; chunkSize <= 5; ++chunkSize) {
+        minijson::StreamParser unicodeStream;
+        for (size_t i = 0; i < unicodeSource.size(); i += chunkSize) {
+            unicodeStream.feed(unicodeSource.substr(i, chunkSize));
+        }
+        assert(unicodeStream.finish()->dump() == unicode->dump());
+    }
+    minijson::ParseOptions utf8;
+    utf8.validateUtf8 = true;
+    [[maybe_unused]] const std::string_view badUtf8 = "[\"\xc3\xa9\", \"\xed\xa0\x80\"]";
+    assert(minijson::parse(badUtf8) && minijson::parse("\"\xc3\xa9\xf0\x9f\x98\x80\"", utf8));
+    assert(minijson::parse(badUtf8, utf8).error().code == ErrorCode::InvalidUtf8);
+    assert(minijson::parse(badUtf8, utf8).error().cursor == 8);
+
+    const auto errorSource = "{\n  \"a\": 1,\n  \"b\" 2\n}";
+    [[maybe_unused]] const auto located = minijson::parse(errorSource).error();
+    assert(located.code == ErrorCode::ExpectedColon && located.message() == "Expected colon");
+    assert(minijson::getLocation(errorSource, located.cursor).line == 3);
+    assert(minijson::getLocation(errorSource, located.cursor).column == 7);
+    assert(located.describe(errorSource)
+        == "Expected colon at line 3, column 7\n  \"b\" 2\n      ^");
+    const auto missing = minijson::MappedFile::open("/nonexistent/file.json");
+    assert(!missing && missing.error().code == ErrorCode::CouldNotOpenFile);
+    assert(missing.error().message() == "Could not open file: No such file or directory");
+
+    minijson::CountingResource reuseResource;
+    minijson::JsonValue reused;
+    [[maybe_unused]] const std::string_view firstMessage
+        = R"({"id": 1, "name": "a long enough name", "tags": ["x", "y"], "a": 1, "a": 2})";
+    [[maybe_unused]] const std::string_view secondMessage
+        = R"({"id": 2, "name": "another long name", "tags": ["z"], "a": 3, "extra": {}})";
+    [[maybe_unused]] auto reuseError = minijson::parseInto(reused, firstMessage, &reuseResource);
+    assert(!reuseError && reused.dump() == minijson::parse(firstMessage)->dump());
+    reuseError = minijson::parseInto(reused, secondMessage, &reuseResource);
+    assert(!reuseError && reused.dump() == minijson::parse(secondMessage)->dump());
+    [[maybe_unused]] const auto allocationsBefore = reuseResource.allocations();
+    reuseError = minijson::parseInto(reused, firstMessage, &reuseResource);
+    assert(!reuseError);
+    reuseError = minijson::parseInto(reused, secondMessage, &reuseResource);
+    assert(!reuseError && reuseResource.allocations() == allocationsBefore);
+    reuseError = minijson::parseInto(reused, "[1, [2]]", &reuseResource);
+    assert(!reuseError && reused[1][0].isInt());
+    reuseError = minijson::parseInto(reused, "[1] 2", &reuseResource);
+    assert(reuseError && reuseError->cursor == 4);
+    // A number that becomes a string has to get it from the resource too
+    minijson::CountingResource slotResource;
+    minijson::JsonValue slotChange;
+    reuseError = minijson::parseInto(slotChange, "[1]", &slotResource);
+    [[maybe_unused]] const auto slotAllocations = slotResource.allocations();
+    reuseError = minijson::parseInto(slotChange, R"(["longer than any small string buffer"])",
+        &slotResource);
+    assert(!reuseError && slotChange[0].isString());
+    assert(slotResource.allocations() == slotAllocations + 1);
+    std::string wideObject = "{";
+    for (size_t i = 0; i < 40; ++i) {
+        wideObject += (i ? ", \"" : "\"") + std::to_string(i % 30) + "\": " + std::to_string(i);
+    }
+    wideObject += "}";
+    reuseError = minijson::parseInto(reused, wideObject);
+    assert(!reuseError && reused.size() == 30);
+    reuseError = minijson::parseInto(reused, wideObject);
+    assert(!reuseError && reused["29"].asInt() == 29);
+    assert(reused.dump() == minijson::parse(wideObject)->dump());
+    minijson::Document reusedDocument;
+    [[maybe_unused]] auto reparsed = reusedDocument.reparse(firstMessage);
+    assert(reparsed);
+    reparsed = reusedDocument.reparse(secondMessage);
+    assert(reparsed && reusedDocument.root()["tags"].size() == 1);
+    reparsed = reusedDocument.reparse("[1,]");
+    assert(!reparsed);
+
+    using minijson::JsonValue;
+    minijson::Document patched;
+    [[maybe_unused]] const auto patchedOk
+        = patched.parse(R"({"name": "a", "tags": ["x"], "old": 1})");
+    assert(patchedOk);
+    auto& patchedRoot = patched.root();
+    patchedRoot.find("name")->asString() = "renamed";
+    patchedRoot.find("tags")->emplaceBack(JsonValue::makeString("y", patched.memoryResource()));
+    patchedRoot.set("count", JsonValue(JsonValue::Int(2)));
+    patchedRoot.set("count", JsonValue(JsonValue::Int(3)));
+    [[maybe_unused]] const auto erased = patchedRoot.erase("old");
+    [[maybe_unused]] const auto erasedAgain = patchedRoot.erase("old");
+    assert(erased && !erasedAgain && !patchedRoot.find("old"));
+    [[maybe_unused]] const auto expectedPatch
+        = R"({"name": "renamed", "tags": ["x", "y"], "count": 3})";
+    assert(patchedRoot.dump() == minijson::parse(expectedPatch)->dump());
+    auto built = JsonValue::makeObject();
+    built.set("list", JsonValue::makeArray()).emplaceBack(JsonValue::Bool(true));
+    built.asObject().try_emplace("list", JsonValue::Int(1));
+    assert(std::as_const(built)["list"][0].isBool());
+    assert(built.find("list")->find(size_t(1)) == nullptr);
+    built.emplace<JsonValue::Int>(5);
+    assert(built.asInt() == 5 && !built.find("list"));
+    // Nothing that is added to a value with a resource of its own stays on the default one
+    minijson::CountingResource mutableResource;
+    auto moved = JsonValue::makeObject(&mutableResource);
+    moved.set("s", JsonValue::makeString("short", &mutableResource));
+    auto movedList = JsonValue::makeArray();
+    movedList.emplaceBack(JsonValue::makeString("a string that is too long for the small buffer"));
+    auto movedCopy = minijson::parse(R"({"k": ["a string that needs an allocation as well"]})");
+    const auto previousDefault = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+    moved.find("s")->asString() = "another string that is too long for the small buffer";
+    moved.set("list", std::move(movedList));
+    moved.set("copy", std::move(*movedCopy));
+    std::pmr::set_default_resource(previousDefault);
+    assert(moved["list"][0].asString().size() > 40 && moved["copy"]["k"][0].isString());
+    assert(moved["s"].asString() == "another string that is too long for the small buffer");
+
+    const auto blob = minijson::encodeTape(*tape);
+    [[maybe_unused]] const auto decoded = minijson::decodeTape(blob);
+    assert(decoded && (*decoded)["arr"][1]["y"].asNumber() == 5.0);
+    assert((*decoded)["obj"]["foo"].asString() == "bar" && decoded->root().size() == 6);
+    assert(minijson::decodeTape(std::string_view(blob).substr(0, blob.size() - 1))
+               .error()
+               .code
+        == ErrorCode::InvalidBinaryTape);
+    auto corrupt = blob;
+    // Replaces the end of the root object with a null
+    const auto lastEntry = 24 + (tape->numEntries() - 1) * 8;
+    const auto null = uint64_t(minijson::TapeTag::Null) << 56;
+    std::memcpy(corrupt.data() + lastEntry, &null, sizeof(null));
+    assert(minijson::decodeTape(corrupt).error().cursor == lastEntry);
+    assert(minijson::decodeTape(corrupt, false));
+    const auto tapePath = std::string(P_tmpdir) + "/minijson-test.tape";
+    [[maybe_unused]] const auto writeError = minijson::writeTapeFile(*tape, tapePath);
+    assert(!writeError);
+    const auto mapped = minijson::openTapeFile(tapePath);
+    assert(mapped && (*mapped)["arr"][1]["y"].asNumber() == 5.0);
+    std::remove(tapePath.c_str());
+    assert(minijson::openTapeFile(tapePath).error().code == ErrorCode::CouldNotOpenFile);
+
+    minijson::Arena sharedArena(64);
+    const minijson::JsonValue::Array kept({ minijson::JsonValue(1.0) }, &sharedArena);
+    const auto concatenated = std::string(R"({"a": 1}{"a": [2, 3]} [4]"x"  )") + wideObject;
+    for (const auto prefetch : { false, true }) {
+        minijson::SequenceOptions sequenceOptions;
+        sequenceOptions.prefetch = prefetch;
+        minijson::DocumentSequence sequence(concatenated, sequenceOptions, &sharedArena);
+        std::vector<std::string> dumps;
+        for (const auto& value : sequence) {
+            dumps.push_back(value.dump());
+        }
+        assert(dumps.size() == 5 && dumps[1] == minijson::parse(R"({"a":[2,3]})")->dump());
+        assert(dumps[3] == "\"x\"" && dumps[4] == minijson::parse(wideObject)->dump());
+        [[maybe_unused]] const auto hasMore = sequence.next();
+        assert(!hasMore && sequence.error().code == ErrorCode::None);
+        assert(sharedArena.capacity() > 0 && kept[0].asNumber() == 1.0);
+        assert((sequence.memoryResource() == &sharedArena) != prefetch);
+
+        minijson::DocumentSequence broken("[1] [2]\n{", sequenceOptions);
+        [[maybe_unused]] auto brokenNext = broken.next();
+        assert(brokenNext && broken.offset() == 0 && broken.endOffset() == 3);
+        brokenNext = broken.next();
+        assert(brokenNext && broken.root()[0].asInt() == 2 && broken.offset() == 4);
+        brokenNext = broken.next();
+        assert(!brokenNext && broken.error().cursor == 9 && !broken.root().isValid());
+        brokenNext = broken.next();
+        assert(!brokenNext);
+    }
+
+    auto frozen = minijson::FrozenDocument::parse(R"({"route": "/a"})");
+    assert(frozen && (**frozen)["route"].asString() == "/a");
+    assert(minijson::FrozenDocument::parse("{").error().code == ErrorCode::UnterminatedObject);
+    minijson::AtomicDocument routes(*frozen);
+    minijson::AtomicDocument::Reader routeReader(routes);
+    const auto firstRoutes = routeReader.get();
+    std::vector<std::thread> routeThreads;
+    for (size_t i = 0; i < 4; ++i) {
+        routeThreads.emplace_back([&routes] {
+            minijson::AtomicDocument::Reader reader(routes);
+            for (size_t n = 0; n < 1000; ++n) {
+                [[maybe_unused]] const auto& route = (*reader.get())["route"];
+                assert(route.isString() && route.asString().size() >= 2);
+            }
+        });
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        minijson::Document reloaded;
+        [[maybe_unused]] const auto reloadedOk
+            = reloaded.parse(R"({"route": "/)" + std::to_string(i) + "\"}");
+        assert(reloadedOk);
+        routes.store(minijson::FrozenDocument::freeze(std::move(reloaded)));
+    }
+    for (auto& thread : routeThreads) {
+        thread.join();
+    }
+    assert(routes.version() == 100 && (*routeReader.get())["route"].asString() == "/99");
+    assert(firstRoutes.use_count() == 2 && (*firstRoutes)["route"].asString() == "/a");
+
+    minijson::JsonValue::Object dictionary;
+    for (size_t i = 0; i < 5000; ++i) {
+        dictionary.try_emplace("user" + std::to_string(i * 7919), minijson::JsonValue::Int(i));
+    }
+    assert(dictionary.find("user" + std::to_string(4999 * 7919))->second.asInt() == 4999);
+    [[maybe_unused]] const auto numErased = dictionary.erase("user0");
+    assert(dictionary.find("user1") == dictionary.end() && numErased == 1);
+    assert(dictionary.size() == 4999 && dictionary.find("user7919")->second.asInt() == 1);
+    for (size_t i = 1; i < 5000; ++i) {
+        const auto key = "user" + std::to_string(i * 7919);
+        assert(dictionary.find(key, minijson::JsonValue::Object::hashKey(key)) != dictionary.end());
+    }
+
+    minijson::ParseStats stats;
+    minijson::CountingResource counting;
+    minijson::ParseOptions withStats;
+    withStats.stats = &stats;
+    const auto statsSource = R"( {"a": [1, 2.5, "x\ty", null, true], "b": {}} )";
+    [[maybe_unused]] const auto withStatsRes = minijson::parse(statsSource, &counting, withStats);
+    assert(withStatsRes);
+    if constexpr (minijson::detail::statsEnabled) {
+        assert(stats.numbers == 2 && stats.integers == 1 && stats.strings == 1);
+        assert(stats.keys == 2 && stats.escapedStrings == 1 && stats.nulls == 1);
+        assert(stats.bools == 1 && stats.arrays == 1 && stats.objects == 2);
+        assert(stats.maxDepth == 2 && stats.bytes == 45 && stats.allocations > 0);
+        assert(stats.allocatedBytes >= stats.allocations);
+    } else {
+        assert(stats.bytes == 0);
+    }
+
     return 0;
 }